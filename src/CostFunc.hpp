@@ -13,7 +13,11 @@ class CostFunc {
 	///This may invoke node modifiers prior to calculating the cost.
 	int getCost(Node * node) {
 		Environment * env = node->env;
-		env->runNodeModifiers(node, MOD_TYPE_BEFORECOST);
+		if(env->nodeMods.size()) {
+			//node mods may change the qubit mapping directly
+			env->runNodeModifiers(node, MOD_TYPE_BEFORECOST);
+			node->rehash();
+		}
 		return _getCost(node);
 	}
 	
@@ -8,13 +8,18 @@
 class CXFrontier : public CostFunc {
   public:
 	int _getCost(Node * node) {
+		DISPATCH_NODE_WIDTH(calcCost, (node));
+	}
+	
+	template <int W>
+	int calcCost(Node * node) {
 		//bool debug = node->cost > 0;//called getCost for second time on this node
 		
 		int cost = 0;
 		int costT = 99999;
 		Environment * env = node->env;
-		GateNode * next2BitGate[env->numPhysicalQubits];
-		int pathLength[env->numPhysicalQubits];
+		GateNode * next2BitGate[W ? W : Node::numQubits];
+		int pathLength[W ? W : Node::numQubits];
 		for(int x = 0; x < env->numPhysicalQubits; x++) {
 			next2BitGate[x] = NULL;
 			pathLength[x] = 0;
@@ -30,11 +35,11 @@ class CXFrontier : public CostFunc {
 			if(sg) {
 				//get latest physical location of logical qubit x:
 				int actualQubit;
-				if(sg->gate->target == x) {
-					actualQubit = node->laq[sg->gate->target];
+				if(sg->gate()->target == x) {
+					actualQubit = node->laq[sg->gate()->target];
 				} else {
-					assert(sg->gate->control == x);
-					actualQubit = node->laq[sg->gate->control];
+					assert(sg->gate()->control == x);
+					actualQubit = node->laq[sg->gate()->control];
 				}
 				
 				//get path length to next 2-qubit gate along this qubit:
@@ -42,19 +47,14 @@ class CXFrontier : public CostFunc {
 				if(!pathLength[actualQubit]) {
 					pathLength[actualQubit] = 1;//since we won't schedule any more gates this cycle
 				}
-				GateNode * temp;
-				if(sg->gate->target == x) {
-					temp = sg->gate->targetChild;
+				if(sg->gate()->target == x) {
+					pathLength[actualQubit] += sg->gate()->targetChainLatency;
+					next2BitGate[actualQubit] = sg->gate()->nextTargetCNOT;
 				} else {
-					assert(sg->gate->control == x);
-					temp = sg->gate->controlChild;
-				}
-				
-				while(temp && temp->control < 0) {
-					pathLength[actualQubit] += temp->optimisticLatency;
-					temp = temp->targetChild;
+					assert(sg->gate()->control == x);
+					pathLength[actualQubit] += sg->gate()->controlChainLatency;
+					next2BitGate[actualQubit] = sg->gate()->nextControlCNOT;
 				}
-				next2BitGate[actualQubit] = temp;
 			}
 		}
 		
@@ -75,11 +75,8 @@ class CXFrontier : public CostFunc {
 					if(!pathLength[physicalTarget]) {
 						pathLength[physicalTarget] = 1;//since we won't schedule any more gates this cycle
 					}
-					GateNode * temp = g;
-					while(temp && temp->control < 0) {
-						pathLength[physicalTarget] += temp->optimisticLatency;
-						temp = temp->targetChild;
-					}
+					pathLength[physicalTarget] += g->optimisticLatency + g->targetChainLatency;
+					GateNode * temp = g->nextTargetCNOT;
 					next2BitGate[physicalTarget] = temp;
 					
 					if(temp) {
@@ -180,9 +177,9 @@ class CXFrontier : public CostFunc {
 					continue;
 				}
 				
-				int minSwaps = env->couplingDistances[physicalControl*env->numPhysicalQubits + physicalTarget] - 1;
+				int minSwaps = env->device->distance(physicalControl, physicalTarget) - 1;
 				if(minSwaps < costT) costT = minSwaps;
-				int totalSwapCost = env->swapCost * minSwaps;
+				int totalSwapCost = env->device->swapUnit * minSwaps;
 				
 				if(length1 < length2) {
 					std::swap(length1, length2);
@@ -192,7 +189,7 @@ class CXFrontier : public CostFunc {
 				//if(debug) std::cerr << "   swaps needed at least: " << minSwaps << "\n";
 				
 				int slack = length1-length2;
-				int effectiveSlack = (slack/env->swapCost) * env->swapCost;
+				int effectiveSlack = (slack/env->device->swapUnit) * env->device->swapUnit;
 				if(effectiveSlack > totalSwapCost) {
 					effectiveSlack = totalSwapCost;
 				}
@@ -200,9 +197,9 @@ class CXFrontier : public CostFunc {
 				//if(debug) std::cerr << "   effective slack cycles: " << effectiveSlack << "\n";
 				
 				int mutualSwapCost = totalSwapCost - effectiveSlack;
-				int extraSwapCost = (0x1 & (mutualSwapCost/env->swapCost)) * env->swapCost;
+				int extraSwapCost = (0x1 & (mutualSwapCost/env->device->swapUnit)) * env->device->swapUnit;
 				mutualSwapCost -= extraSwapCost;
-				assert((mutualSwapCost % env->swapCost) == 0);
+				assert((mutualSwapCost % env->device->swapUnit) == 0);
 				mutualSwapCost = mutualSwapCost >> 1;
 				
 				int cost1 = g->optimisticLatency + g->criticality + length1 + mutualSwapCost;
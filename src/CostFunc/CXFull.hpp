@@ -8,14 +8,19 @@
 class CXFull : public CostFunc {
   public:
 	int _getCost(Node * node) {
+		DISPATCH_NODE_WIDTH(calcCost, (node));
+	}
+	
+	template <int W>
+	int calcCost(Node * node) {
 		//bool debug = node->cost > 0;//called getCost for second time on this node
 		
 		int cost = 0;
 		int costT = 99999;
 		Environment * env = node->env;
-		GateNode * next2BitGate[env->numPhysicalQubits];
-		int pathLength[env->numPhysicalQubits];
-		GateNode * next2BitGate2[env->numPhysicalQubits];
+		GateNode * next2BitGate[W ? W : Node::numQubits];
+		int pathLength[W ? W : Node::numQubits];
+		GateNode * next2BitGate2[W ? W : Node::numQubits];
 		for(int x = 0; x < env->numPhysicalQubits; x++) {
 			next2BitGate[x] = NULL;
 			next2BitGate2[x] = NULL;
@@ -32,11 +37,11 @@ class CXFull : public CostFunc {
 			if(sg) {
 				//get latest physical location of logical qubit x:
 				int actualQubit;
-				if(sg->gate->target == x) {
-					actualQubit = node->laq[sg->gate->target];
+				if(sg->gate()->target == x) {
+					actualQubit = node->laq[sg->gate()->target];
 				} else {
-					assert(sg->gate->control == x);
-					actualQubit = node->laq[sg->gate->control];
+					assert(sg->gate()->control == x);
+					actualQubit = node->laq[sg->gate()->control];
 				}
 				
 				//get path length to next 2-qubit gate along this qubit:
@@ -44,19 +49,14 @@ class CXFull : public CostFunc {
 				if(!pathLength[actualQubit]) {
 					pathLength[actualQubit] = 1;//since we won't schedule any more gates this cycle
 				}
-				GateNode * temp;
-				if(sg->gate->target == x) {
-					temp = sg->gate->targetChild;
+				if(sg->gate()->target == x) {
+					pathLength[actualQubit] += sg->gate()->targetChainLatency;
+					next2BitGate[actualQubit] = sg->gate()->nextTargetCNOT;
 				} else {
-					assert(sg->gate->control == x);
-					temp = sg->gate->controlChild;
-				}
-				
-				while(temp && temp->control < 0) {
-					pathLength[actualQubit] += temp->optimisticLatency;
-					temp = temp->targetChild;
+					assert(sg->gate()->control == x);
+					pathLength[actualQubit] += sg->gate()->controlChainLatency;
+					next2BitGate[actualQubit] = sg->gate()->nextControlCNOT;
 				}
-				next2BitGate[actualQubit] = temp;
 			}
 		}
 		
@@ -77,11 +77,8 @@ class CXFull : public CostFunc {
 					if(!pathLength[physicalTarget]) {
 						pathLength[physicalTarget] = 1;//since we won't schedule any more gates this cycle
 					}
-					GateNode * temp = g;
-					while(temp && temp->control < 0) {
-						pathLength[physicalTarget] += temp->optimisticLatency;
-						temp = temp->targetChild;
-					}
+					pathLength[physicalTarget] += g->optimisticLatency + g->targetChainLatency;
+					GateNode * temp = g->nextTargetCNOT;
 					next2BitGate[physicalTarget] = temp;
 					
 					if(temp) {
@@ -171,9 +168,9 @@ class CXFull : public CostFunc {
 						continue;
 					}
 					
-					int minSwaps = env->couplingDistances[physicalControl*env->numPhysicalQubits + physicalTarget] - 1;
+					int minSwaps = env->device->distance(physicalControl, physicalTarget) - 1;
 					if(!iterNum && minSwaps < costT) costT = minSwaps;
-					int totalSwapCost = env->swapCost * minSwaps;
+					int totalSwapCost = env->device->swapUnit * minSwaps;
 					
 					if(length1 < length2) {
 						std::swap(length1, length2);
@@ -183,7 +180,7 @@ class CXFull : public CostFunc {
 					//if(debug) std::cerr << "   swaps needed at least: " << minSwaps << "\n";
 					
 					int slack = length1-length2;
-					int effectiveSlack = (slack/env->swapCost) * env->swapCost;
+					int effectiveSlack = (slack/env->device->swapUnit) * env->device->swapUnit;
 					if(effectiveSlack > totalSwapCost) {
 						effectiveSlack = totalSwapCost;
 					}
@@ -191,9 +188,9 @@ class CXFull : public CostFunc {
 					//if(debug) std::cerr << "   effective slack cycles: " << effectiveSlack << "\n";
 					
 					int mutualSwapCost = totalSwapCost - effectiveSlack;
-					int extraSwapCost = (0x1 & (mutualSwapCost/env->swapCost)) * env->swapCost;
+					int extraSwapCost = (0x1 & (mutualSwapCost/env->device->swapUnit)) * env->device->swapUnit;
 					mutualSwapCost -= extraSwapCost;
-					assert((mutualSwapCost % env->swapCost) == 0);
+					assert((mutualSwapCost % env->device->swapUnit) == 0);
 					mutualSwapCost = mutualSwapCost >> 1;
 					
 					int cost1 = g->optimisticLatency + g->criticality + length1 + mutualSwapCost;
@@ -230,15 +227,12 @@ class CXFull : public CostFunc {
 					int physicalTarget = node->laq[g->target];
 					int physicalControl = node->laq[g->control];
 					if(physicalTarget == x) {
-						g = g->targetChild;
+						addlPath += g->targetChainLatency;
+						g = g->nextTargetCNOT;
 					} else {
 						assert(physicalControl == x);
-						g = g->controlChild;
-					}
-					
-					while(g && g->control < 0) {
-						addlPath += g->optimisticLatency;
-						g = g->targetChild;
+						addlPath += g->controlChainLatency;
+						g = g->nextControlCNOT;
 					}
 					
 					if(g) {
@@ -55,9 +55,9 @@ class SimpleCost : public CostFunc {
 			}
 			
 			if(control >= 0 && target >= 0) {
-				int dist = env->couplingDistances[control*env->numPhysicalQubits + target];
+				int dist = env->device->distance(control, target);
 				if(dist < costT) costT = dist - 1;
-				int minSwapCost = env->swapCost * (dist / 2);
+				int minSwapCost = env->device->swapUnit * (dist / 2);
 				assert(minSwapCost >= 0);
 				
 				if(dist > 1) {//at least one node between target and control
@@ -66,10 +66,10 @@ class SimpleCost : public CostFunc {
 						tempcost2 += minSwapCost;
 					} else if(tempcost < tempcost2) {
 						tempcost += minSwapCost;
-						tempcost2 += minSwapCost - env->swapCost;
+						tempcost2 += minSwapCost - env->device->swapUnit;
 					} else {
 						tempcost2 += minSwapCost;
-						tempcost += minSwapCost - env->swapCost;
+						tempcost += minSwapCost - env->device->swapUnit;
 					}
 				}
 			}
@@ -1,41 +1,90 @@
 #ifndef DEFAULTEXPANDER_HPP
 #define DEFAULTEXPANDER_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include <iostream>
 #include "Expander.hpp"
 #include "Queue.hpp"
 #include "CostFunc.hpp"
+#include "QubitMask.hpp"
 
-//return true iff inserting swap g in node's child would make a useless swap cycle
+//return true iff inserting swap g in node's child would make a useless swap cycle,
+//i.e. the last two-qubit gate on either of its qubits was this same swap
 bool isCyclic(Node * node, GateNode * g) {
-	int target = g->target;
-	int control = g->control;
+	unsigned int last = node->lastTwoQubitGate[g->target];
+	if(!last || last != node->lastTwoQubitGate[g->control]) {
+		return false;
+	}
+	return node->env->schedule->get(last)->gate() == g;
+}
+
+class DefaultExpander : public Expander {
+  private:
+	//state shared by one expansion's calls to buildSubsets
+	template <int W>
+	struct SubsetSearch {
+		Node * node;//the node being expanded
+		vector<GateNode*> * possibleGates;
+		vector<GateNode*> * singleCycleGates;
+		QubitMask<W ? W : 64> * gateQubits;//physical qubits used by each possible gate
+		bool useMasks;//whether gateQubits is filled in
+		vector<pair<unsigned long long, Node*> > children;//finished children, with the subset of possibleGates each one scheduled
+	};
 	
-	if(node->lastGate[target] && node->lastGate[control]) {
-		LinkedStack<ScheduledGate*> * schdule = node->scheduled;
-		while(schdule->size > 0) {
-			if(schdule->value->gate == g) {
-				return true;
+	//Finishes partial, a child of search.node that scheduled the specified subset of possibleGates.
+	//First, for each possible gate y >= first that doesn't conflict, recurse on a copy of partial that also schedules gate y.
+	//That way each subset's child is built from the child for the subset minus its last gate, with just one more scheduleGate.
+	template <int W>
+	void buildSubsets(SubsetSearch<W> & search, Node * partial, unsigned long long subset, unsigned int first, const QubitMask<W ? W : 64> & used) {
+		Node * node = search.node;
+		for(unsigned int y = first; y < search.possibleGates->size(); y++) {
+			if(search.useMasks && used.overlaps(search.gateQubits[y])) {
+				continue;
+			}
+			
+			//if this gate can't be scheduled here, then it can't be scheduled in any bigger subset that has partial's gates either
+			GateNode * g = (*search.possibleGates)[y];
+			Node * child = partial->prepSibling();
+			bool good;
+			if(node->cycle >= -1) {
+				good = child->scheduleGate(g);
 			} else {
-				int c = schdule->value->physicalControl;
-				int t = schdule->value->physicalTarget;
-				if(c >= 0) {
-					if(c == control || c == target || t == control || t == target) {
-						return false;
-					}
-				}
+				good = child->swapQubits(g->target, g->control);
+			}
+			if(!good) {
+				delete child;
+				continue;
 			}
-			schdule = schdule->next;
+			
+			QubitMask<W ? W : 64> childUsed = used;
+			if(search.useMasks) {
+				childUsed |= search.gateQubits[y];
+			}
+			buildSubsets<W>(search, child, subset | (1ULL << y), y + 1, childUsed);
 		}
+		
+		//Schedule as many of the 1-cycle ready gates as we can:
+		for(unsigned int y = 0; y < search.singleCycleGates->size(); y++) {
+			partial->scheduleGate((*search.singleCycleGates)[y]);
+		}
+		
+		int cycleMod = (partial->cycle < 0) ? partial->cycle : 0;
+		partial->cycle -= cycleMod;
+		partial->cost = node->env->cost->getCost(partial);
+		partial->cycle += cycleMod;
+		
+		search.children.push_back(make_pair(subset, partial));
 	}
-	return false;
-}
-
-class DefaultExpander : public Expander {
+	
   public:
 	bool expand(Queue * nodes, Node * node) {
+		DISPATCH_NODE_WIDTH(expandNode, (nodes, node));
+	}
+	
+	template <int W>
+	bool expandNode(Queue * nodes, Node * node) {
 		//return false if we're done expanding
 		if(nodes->getBestFinalNode() && node->cost >= nodes->getBestFinalNode()->cost) {
 			return false;
@@ -43,18 +92,18 @@ class DefaultExpander : public Expander {
 		
 		unsigned int nodesSize = nodes->size();
 		
-		bool noMoreCX[node->env->numPhysicalQubits];
+		bool noMoreCX[W ? W : Node::numQubits];
 		for(int x = 0; x < node->env->numPhysicalQubits; x++) {
 			noMoreCX[x] = false;
 			ScheduledGate * sg = node->lastNonSwapGate[x];
 			if(sg) {
-				if(sg->gate->target == x) {
-					if(!sg->gate->nextTargetCNOT) {
+				if(sg->gate()->target == x) {
+					if(!sg->gate()->nextTargetCNOT) {
 						noMoreCX[x] = true;
 					}
 				} else {
-					assert(sg->gate->control == x);
-					if(!sg->gate->nextControlCNOT) {
+					assert(sg->gate()->control == x);
+					if(!sg->gate()->nextControlCNOT) {
 						noMoreCX[x] = true;
 					}
 				}
@@ -106,15 +155,13 @@ class DefaultExpander : public Expander {
 			}
 			
 			if(good && control >= 0 && target >= 0) {//gate has 2 qubits
-				if(node->env->couplings.count(make_pair(target,control)) <= 0) {
-					if(node->env->couplings.count(make_pair(control,target)) <= 0) {
-						good = false;
-					}
+				if(!node->env->device->isCoupled(target, control)) {
+					good = false;
 				}
 			}
 			
 			if(good) {
-				int latency = node->env->latency->getLatency(g->name, (control >= 0 ? 2 : 1), target, control);
+				int latency = node->env->latency->getLatency(g->type, (control >= 0 ? 2 : 1), target, control);
 				if(latency == 1) {
 					singleCycleGates.push_back(g);
 				} else {
@@ -123,8 +170,8 @@ class DefaultExpander : public Expander {
 			}
 		}
 		//generate list of valid gates, based on possible swaps
-		for(unsigned int x = 0; x < node->env->couplings.size(); x++) {
-			GateNode * g = node->env->possibleSwaps[x];
+		for(unsigned int x = 0; x < node->env->device->swaps.size(); x++) {
+			GateNode * g = node->env->device->swaps[x];
 			int target = g->target;//note: since g is swap, this is already a physical target
 			int control = g->control;//note: since g is swap, this is already a physical control
 			int logicalTarget = (target >= 0) ? node->qal[target] : -1;
@@ -143,7 +190,9 @@ class DefaultExpander : public Expander {
 			good = good && usesLogicalQubit;
 			
 			//make sure this swap involves a qubit that has more 2-qubit gates ahead
-			if(good && (noMoreCX[logicalTarget] && noMoreCX[logicalControl])) {
+			bool targetDone = logicalTarget < 0 || noMoreCX[logicalTarget];
+			bool controlDone = logicalControl < 0 || noMoreCX[logicalControl];
+			if(good && targetDone && controlDone) {
 				good = false;
 			}
 			
@@ -152,7 +201,7 @@ class DefaultExpander : public Expander {
 				if(logicalTarget >= 0) {
 					ScheduledGate * t = node->lastNonSwapGate[logicalTarget];
 					if(t) {
-						GateNode * tg = t->gate;
+						GateNode * tg = t->gate();
 						if(tg->target == logicalTarget) {
 							if(tg->targetChild) {
 								usesUsefulLogicalQubit = true;
@@ -171,7 +220,7 @@ class DefaultExpander : public Expander {
 				if(logicalControl >= 0) {
 					ScheduledGate * c = node->lastNonSwapGate[logicalControl];
 					if(c) {
-						GateNode * cg = c->gate;
+						GateNode * cg = c->gate();
 						if(cg->target == logicalControl) {
 							if(cg->targetChild) {
 								usesUsefulLogicalQubit = true;
@@ -222,37 +271,41 @@ class DefaultExpander : public Expander {
 		}
 		
 		assert(possibleGates.size() < 64); //or else I need to do this differently
-		unsigned long long numIters = 1LL << possibleGates.size();
-		for(unsigned long long x = 0; x < numIters; x++) {
-			Node * child = node->prepChild();
-			bool good = true;
-			//Schedule a unique subset of {swaps and 2-qubit gates}:
-			for(unsigned int y = 0; good && y < possibleGates.size(); y++) {
-				if(x & (1LL << y)) {
-					if(node->cycle >= -1) {
-						good = good && child->scheduleGate(possibleGates[y]);
-					} else {
-						good = good && child->swapQubits(possibleGates[y]->target, possibleGates[y]->control);
-					}
+		
+		//Physical qubits used by each possible gate.
+		//Swaps come after all other gates in possibleGates, so no swap in a subset moves a gate scheduled before it.
+		//That means a child can schedule a subset iff no two of its gates share a qubit here.
+		//(Not available on devices too wide for QubitMask, or before cycle -1, where we swap without scheduling.)
+		bool useMasks = W && node->cycle >= -1;
+		QubitMask<W ? W : 64> gateQubits[64];
+		if(useMasks) {
+			for(unsigned int y = 0; y < possibleGates.size(); y++) {
+				GateNode * g = possibleGates[y];
+				if(g->isSwap) {
+					gateQubits[y].add(g->target);
+					gateQubits[y].add(g->control);
+				} else {
+					gateQubits[y].add((g->target < 0) ? -1 : node->laq[g->target]);
+					gateQubits[y].add((g->control < 0) ? -1 : node->laq[g->control]);
 				}
 			}
-			
-			if(!good) {
+		}
+		
+		//Build a child for every subset of possibleGates, depth-first:
+		SubsetSearch<W> search;
+		search.node = node;
+		search.possibleGates = &possibleGates;
+		search.singleCycleGates = &singleCycleGates;
+		search.gateQubits = gateQubits;
+		search.useMasks = useMasks;
+		buildSubsets<W>(search, node->prepChild(), 0, 0, QubitMask<W ? W : 64>());
+		
+		//Push children in the order we'd get from counting through the subsets, so ties in the queue break the same way:
+		std::sort(search.children.begin(), search.children.end());
+		for(unsigned int x = 0; x < search.children.size(); x++) {
+			Node * child = search.children[x].second;
+			if(!nodes->push(child)) {
 				delete child;
-			} else {
-				//Schedule as many of the 1-cycle ready gates as we can:
-				for(unsigned int y = 0; good && y < singleCycleGates.size(); y++) {
-					child->scheduleGate(singleCycleGates[y]);
-				}
-				
-				int cycleMod = (child->cycle < 0) ? child->cycle : 0;
-				child->cycle -= cycleMod;
-				child->cost = node->env->cost->getCost(child);
-				child->cycle += cycleMod;
-				
-				if(!nodes->push(child)) {
-					delete child;
-				}
 			}
 		}
 		
@@ -121,10 +121,8 @@ class GreedyTopK : public Expander {
 			}
 			
 			if(good && control >= 0 && target >= 0) {//gate has 2 qubits
-				if(node->env->couplings.count(make_pair(target,control)) <= 0) {
-					if(node->env->couplings.count(make_pair(control,target)) <= 0) {
-						good = false;
-					}
+				if(!node->env->device->isCoupled(target, control)) {
+					good = false;
 				}
 			}
 			
@@ -136,8 +134,8 @@ class GreedyTopK : public Expander {
 				}
 			}
 		}
-		for(unsigned int x = 0; x < node->env->couplings.size(); x++) {
-			GateNode * g = node->env->possibleSwaps[x];
+		for(unsigned int x = 0; x < node->env->device->swaps.size(); x++) {
+			GateNode * g = node->env->device->swaps[x];
 			int target = g->target;//note: since g is swap, this is already the physical target
 			int control = g->control;//note: since g is swap, this is already the physical control
 			int logicalTarget = (target >= 0) ? node->qal[target] : -1;
@@ -149,9 +147,9 @@ class GreedyTopK : public Expander {
 				GateNode * cx = CXFrontier[logicalTarget];
 				assert(cx->target >= 0);
 				assert(cx->control >= 0);
-				int currentDist = node->env->couplingDistances[node->laq[cx->control]*node->env->numPhysicalQubits + node->laq[cx->target]];
+				int currentDist = node->env->device->distance(node->laq[cx->control], node->laq[cx->target]);
 				assert(node->swapQubits(target, control));
-				int hypotheticDist = node->env->couplingDistances[node->laq[cx->control]*node->env->numPhysicalQubits + node->laq[cx->target]];
+				int hypotheticDist = node->env->device->distance(node->laq[cx->control], node->laq[cx->target]);
 				assert(node->swapQubits(target, control));
 				
 				if(hypotheticDist < currentDist) {
@@ -164,9 +162,9 @@ class GreedyTopK : public Expander {
 				GateNode * cx = CXFrontier[logicalControl];
 				assert(cx->target >= 0);
 				assert(cx->control >= 0);
-				int currentDist = node->env->couplingDistances[node->laq[cx->control]*node->env->numPhysicalQubits + node->laq[cx->target]];
+				int currentDist = node->env->device->distance(node->laq[cx->control], node->laq[cx->target]);
 				assert(node->swapQubits(target, control));
-				int hypotheticDist = node->env->couplingDistances[node->laq[cx->control]*node->env->numPhysicalQubits + node->laq[cx->target]];
+				int hypotheticDist = node->env->device->distance(node->laq[cx->control], node->laq[cx->target]);
 				assert(node->swapQubits(target, control));
 				
 				if(hypotheticDist < currentDist) {
@@ -193,7 +191,7 @@ class GreedyTopK : public Expander {
 				if(logicalTarget >= 0) {
 					ScheduledGate * t = node->lastNonSwapGate[logicalTarget];
 					if(t) {
-						GateNode * tg = t->gate;
+						GateNode * tg = t->gate();
 						if(tg->target == logicalTarget) {
 							if(tg->targetChild) {
 								usesUsefulLogicalQubit = true;
@@ -212,7 +210,7 @@ class GreedyTopK : public Expander {
 				if(logicalControl >= 0) {
 					ScheduledGate * c = node->lastNonSwapGate[logicalControl];
 					if(c) {
-						GateNode * cg = c->gate;
+						GateNode * cg = c->gate();
 						if(cg->target == logicalControl) {
 							if(cg->targetChild) {
 								usesUsefulLogicalQubit = true;
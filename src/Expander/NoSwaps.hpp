@@ -29,6 +29,7 @@ class NoSwaps : public Expander {
 				node->laq[x] = -1;
 				node->qal[x] = -1;
 			}
+			node->rehash();
 		}
 		
 		//if this node has any unmapped qubits affecting frontier, make alternate nodes where they're mapped:
@@ -55,15 +56,13 @@ class NoSwaps : public Expander {
 				int physT = n->laq[g->target];
 				if(physC < 0 && physT < 0) {
 					addedNodes = true;
-					for(unsigned int x = 0; x < env->couplings.size(); x++) {
-						GateNode * sw = env->possibleSwaps[x];
+					for(unsigned int x = 0; x < env->device->swaps.size(); x++) {
+						GateNode * sw = env->device->swaps[x];
 						if(n->qal[sw->control] < 0 && n->qal[sw->target] < 0) {
 							Node * n1 = n->prepChild();
 							n1->cycle--;
-							n1->laq[g->control] = sw->control;
-							n1->laq[g->target] = sw->target;
-							n1->qal[sw->control] = g->control;
-							n1->qal[sw->target] = g->target;
+							n1->mapQubit(g->control, sw->control);
+							n1->mapQubit(g->target, sw->target);
 							n1->cost = n->cost-1;//env->cost->getCost(n1);
 							if(nodes->push(n1)) {
 								numAdded++;
@@ -73,10 +72,8 @@ class NoSwaps : public Expander {
 							
 							Node * n2 = n->prepChild();
 							n2->cycle--;
-							n2->laq[g->control] = sw->target;
-							n2->laq[g->target] = sw->control;
-							n2->qal[sw->control] = g->target;
-							n2->qal[sw->target] = g->control;
+							n2->mapQubit(g->control, sw->target);
+							n2->mapQubit(g->target, sw->control);
 							n2->cost = n->cost-1;//env->cost->getCost(n2);
 							if(nodes->push(n2)) {
 								numAdded++;
@@ -87,26 +84,13 @@ class NoSwaps : public Expander {
 					}
 				} else if(physC < 0) {
 					addedNodes = true;
-					for(unsigned int x = 0; x < env->couplings.size(); x++) {
-						GateNode * sw = env->possibleSwaps[x];
-						if(n->qal[sw->control] < 0 && n->qal[sw->target] == g->target) {
+					DeviceModel * device = env->device;
+					for(int x = device->neighborStart[physT]; x < device->neighborStart[physT + 1]; x++) {
+						int q = device->neighbors[x];
+						if(n->qal[q] < 0) {
 							Node * n1 = n->prepChild();
 							n1->cycle--;
-							n1->laq[g->control] = sw->control;
-							n1->qal[sw->control] = g->control;
-							assert(n1->laq[g->target] == sw->target);
-							n1->cost = n->cost-1;//env->cost->getCost(n1);
-							if(nodes->push(n1)) {
-								numAdded++;
-							} else {
-								delete n1;
-							}
-						} else if(n->qal[sw->target] < 0 && n->qal[sw->control] == g->target) {
-							Node * n1 = n->prepChild();
-							n1->cycle--;
-							n1->laq[g->control] = sw->target;
-							n1->qal[sw->target] = g->control;
-							assert(n1->laq[g->target] == sw->control);
+							n1->mapQubit(g->control, q);
 							n1->cost = n->cost-1;//env->cost->getCost(n1);
 							if(nodes->push(n1)) {
 								numAdded++;
@@ -117,26 +101,13 @@ class NoSwaps : public Expander {
 					}
 				} else if(physT < 0) {
 					addedNodes = true;
-					for(unsigned int x = 0; x < env->couplings.size(); x++) {
-						GateNode * sw = env->possibleSwaps[x];
-						if(n->qal[sw->control] < 0 && n->qal[sw->target] == g->control) {
-							Node * n1 = n->prepChild();
-							n1->cycle--;
-							n1->laq[g->target] = sw->control;
-							n1->qal[sw->control] = g->target;
-							assert(n1->laq[g->control] == sw->target);
-							n1->cost = n->cost-1;//env->cost->getCost(n1);
-							if(nodes->push(n1)) {
-								numAdded++;
-							} else {
-								delete n1;
-							}
-						} else if(n->qal[sw->target] < 0 && n->qal[sw->control] == g->control) {
+					DeviceModel * device = env->device;
+					for(int x = device->neighborStart[physC]; x < device->neighborStart[physC + 1]; x++) {
+						int q = device->neighbors[x];
+						if(n->qal[q] < 0) {
 							Node * n1 = n->prepChild();
 							n1->cycle--;
-							n1->laq[g->target] = sw->target;
-							n1->qal[sw->target] = g->target;
-							assert(n1->laq[g->control] == sw->control);
+							n1->mapQubit(g->target, q);
 							n1->cost = n->cost-1;//env->cost->getCost(n1);
 							if(nodes->push(n1)) {
 								numAdded++;
@@ -176,10 +147,8 @@ class NoSwaps : public Expander {
 			if(good && control >= 0 && target >= 0) {//gate has 2 qubits
 				int physicalTarget = node->laq[target];
 				int physicalControl = node->laq[control];
-				if(node->env->couplings.count(make_pair(physicalTarget,physicalControl)) <= 0) {
-					if(node->env->couplings.count(make_pair(physicalControl,physicalTarget)) <= 0) {
-						good = false;
-					}
+				if(!node->env->device->isCoupled(physicalTarget, physicalControl)) {
+					good = false;
 				}
 			}
 			
@@ -21,6 +21,12 @@ class Filter {
 		//if this filter retains node info, delete the filter's records of node n
 	}
 	
+	///Return true iff this filter compares new nodes against nodes that have already been popped,
+	///so main has to keep popped nodes in memory (see -retainPopped)
+	virtual bool needsPoppedNodes() {
+		return true;
+	}
+	
 	virtual Filter * createEmptyCopy() = 0;
 	
 	virtual int setArgs(char** argv) {
@@ -0,0 +1,87 @@
+#ifndef BLOCKEDBLOOMFILTER_HPP
+#define BLOCKEDBLOOMFILTER_HPP
+
+#include "Node.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/**
+ * Blocked Bloom filter of hash values, for the filters to skip looking up nodes they've never seen.
+ * Each hash value sets NUM_BITS bits in a single 64-byte block (aligned to a cache line),
+	so a lookup touches one cache line.
+ * It can't forget hash values: after removing entries from a table, rebuild the filter from what's left.
+ */
+class BlockedBloomFilter {
+  private:
+	static const int WORDS_PER_BLOCK = 8;
+	static const int NUM_BITS = 6;//bits set per hash value
+	
+	uint64_t * words = 0;
+	std::size_t mask = 0;//number of blocks minus one; the number of blocks is a power of 2
+	
+	inline uint64_t * block(uint64_t h) const {
+		return words + (h & mask) * WORDS_PER_BLOCK;
+	}
+
+  public:
+	BlockedBloomFilter() {
+	}
+	
+	~BlockedBloomFilter() {
+		std::free(words);
+	}
+	
+	BlockedBloomFilter(const BlockedBloomFilter &) = delete;
+	BlockedBloomFilter & operator=(const BlockedBloomFilter &) = delete;
+	
+	///Forget every hash value, and make room for about the specified number of them (at 16 bits each)
+	void reset(std::size_t capacity) {
+		std::size_t numBlocks = 1;
+		while(numBlocks * WORDS_PER_BLOCK * 64 < capacity * 16) {
+			numBlocks <<= 1;
+		}
+		std::free(words);
+		void * memory = 0;
+		if(posix_memalign(&memory, 64, numBlocks * WORDS_PER_BLOCK * sizeof(uint64_t))) {
+			std::cerr << "FATAL ERROR: couldn't allocate " << numBlocks * WORDS_PER_BLOCK * sizeof(uint64_t) << " bytes for a Bloom filter.\n";
+			exit(1);
+		}
+		std::memset(memory, 0, numBlocks * WORDS_PER_BLOCK * sizeof(uint64_t));
+		words = (uint64_t*) memory;
+		mask = numBlocks - 1;
+	}
+	
+	inline void insert(std::size_t hash) {
+		uint64_t h = Node::mix64(hash);
+		uint64_t * b = block(h);
+		//take each bit's position (9 bits: word and bit) from a second hash, independent of the block index:
+		uint64_t bits = Node::mix64(h);
+		for(int x = 0; x < NUM_BITS; x++) {
+			unsigned int bit = (bits >> (9 * x)) & 511;
+			b[bit >> 6] |= 1ULL << (bit & 63);
+		}
+	}
+	
+	///Returns false if the hash value was definitely never inserted (since the last reset)
+	inline bool mayContain(std::size_t hash) const {
+		uint64_t h = Node::mix64(hash);
+		const uint64_t * b = block(h);
+		uint64_t bits = Node::mix64(h);
+		for(int x = 0; x < NUM_BITS; x++) {
+			unsigned int bit = (bits >> (9 * x)) & 511;
+			if(!(b[bit >> 6] & (1ULL << (bit & 63)))) {
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	///Number of bytes held by the filter
+	inline std::size_t getBytes() const {
+		return words ? (mask + 1) * WORDS_PER_BLOCK * sizeof(uint64_t) : 0;
+	}
+};
+
+#endif
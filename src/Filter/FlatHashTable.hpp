@@ -0,0 +1,220 @@
+#ifndef FLATHASHTABLE_HPP
+#define FLATHASHTABLE_HPP
+
+#include "Node.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/**
+ * Flat hash table of (hash value, value) pairs for the filters; several values may share a hash value.
+ * Values are nodes, or anything else where 0 can stand for an empty slot.
+ * It uses open addressing with linear probing, in one array of 16-byte slots aligned so that 4 slots fill a cache line,
+	so a lookup usually touches a single cache line, and empty hash values cost nothing.
+ * Deletes shift the rest of the probe run back instead of leaving tombstones.
+ * Values sharing a hash value stay in the order a vector would keep them in:
+	insert appends, and remove moves the last one into the removed one's place.
+ */
+template <class Value>
+class FlatHashTable {
+  private:
+	struct Slot {
+		std::size_t hash;
+		Value value;//0 iff the slot is empty
+	};
+	
+	Slot * slots = 0;
+	std::size_t mask = 0;//capacity minus one; the capacity is a power of 2
+	std::size_t numEntries = 0;
+	static const std::size_t MIN_CAPACITY = 64;
+	
+	//the filters' hash values don't spread well over the low bits, so mix them first:
+	inline std::size_t home(std::size_t hash) const {
+		unsigned long long h = hash;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		return (std::size_t) h & mask;
+	}
+	
+	static Slot * allocate(std::size_t capacity) {
+		void * memory = 0;
+		if(posix_memalign(&memory, 64, capacity * sizeof(Slot))) {
+			std::cerr << "FATAL ERROR: couldn't allocate " << capacity * sizeof(Slot) << " bytes for a filter's hash table.\n";
+			exit(1);
+		}
+		std::memset(memory, 0, capacity * sizeof(Slot));
+		return (Slot*) memory;
+	}
+	
+	inline void place(std::size_t hash, Value value) {
+		std::size_t x = home(hash);
+		while(slots[x].value) {
+			x = (x + 1) & mask;
+		}
+		slots[x].hash = hash;
+		slots[x].value = value;
+	}
+	
+	void grow() {
+		Slot * old = slots;
+		std::size_t oldCapacity = mask + 1;
+		std::size_t capacity = old ? 2 * oldCapacity : MIN_CAPACITY;
+		slots = allocate(capacity);
+		mask = capacity - 1;
+		if(!old) {
+			return;
+		}
+		
+		//reinsert in probe order, starting right after an empty slot, so values sharing a hash value keep their order:
+		std::size_t start = 0;
+		while(old[start].value) {
+			start++;
+		}
+		for(std::size_t y = 1; y <= oldCapacity; y++) {
+			Slot & s = old[(start + y) & (oldCapacity - 1)];
+			if(s.value) {
+				place(s.hash, s.value);
+			}
+		}
+		std::free(old);
+	}
+	
+	//empty the specified slot, shifting back later entries of its probe run that may move closer to their home slot
+	void erase(std::size_t x) {
+		std::size_t next = (x + 1) & mask;
+		while(slots[next].value) {
+			std::size_t h = home(slots[next].hash);
+			//an entry can fill the hole unless its home lies cyclically within (x, next]:
+			bool stays = (x <= next) ? (x < h && h <= next) : (x < h || h <= next);
+			if(!stays) {
+				slots[x] = slots[next];
+				x = next;
+			}
+			next = (next + 1) & mask;
+		}
+		slots[x].value = 0;
+		numEntries--;
+	}
+
+  public:
+	FlatHashTable() {
+	}
+	
+	~FlatHashTable() {
+		std::free(slots);
+	}
+	
+	FlatHashTable(const FlatHashTable &) = delete;
+	FlatHashTable & operator=(const FlatHashTable &) = delete;
+	
+	///Put the indices of the slots holding values with the specified hash value into found, oldest first
+	inline void find(std::size_t hash, std::vector<std::size_t> & found) const {
+		found.clear();
+		if(!slots) {
+			return;
+		}
+		for(std::size_t x = home(hash); slots[x].value; x = (x + 1) & mask) {
+			if(slots[x].hash == hash) {
+				found.push_back(x);
+			}
+		}
+	}
+	
+	inline Value at(std::size_t slot) const {
+		return slots[slot].value;
+	}
+	
+	///Replace the (nonzero) value in the specified slot, keeping its hash value
+	inline void set(std::size_t slot, Value value) {
+		slots[slot].value = value;
+	}
+	
+	///Ask the CPU to start loading the node in the specified slot, along with the start of its per-qubit arrays (for tables of nodes)
+	inline void prefetchNode(std::size_t slot) const {
+		__builtin_prefetch(slots[slot].value);
+		__builtin_prefetch(slots[slot].value->storage());
+	}
+	
+	///Add a value after every value already stored with the same hash value
+	void insert(std::size_t hash, Value value) {
+		if(isFull()) {
+			grow();
+		}
+		place(hash, value);
+		numEntries++;
+	}
+	
+	///Remove the value in slot found[index], where found came from find() (and the removals since);
+	///the last of found takes its place, just like removing from a vector by swapping with the last element
+	void removeFound(std::vector<std::size_t> & found, unsigned int index) {
+		std::size_t last = found.back();
+		found.pop_back();
+		if(index < found.size()) {
+			slots[found[index]].value = slots[last].value;
+		}
+		//erasing the last match only moves entries after it, so the other slots in found stay put
+		erase(last);
+	}
+	
+	///Remove the specified value, which was inserted with the specified hash value; returns false if it isn't here
+	bool remove(std::size_t hash, Value value, std::vector<std::size_t> & scratch) {
+		find(hash, scratch);
+		for(unsigned int x = 0; x < scratch.size(); x++) {
+			if(slots[scratch[x]].value == value) {
+				removeFound(scratch, x);
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	///Call f on the hash value of every value in the table
+	template <class Function>
+	void forEachHash(Function f) const {
+		for(std::size_t x = 0; slots && x <= mask; x++) {
+			if(slots[x].value) {
+				f(slots[x].hash);
+			}
+		}
+	}
+	
+	///Call f on every value in the table
+	template <class Function>
+	void forEachValue(Function f) const {
+		for(std::size_t x = 0; slots && x <= mask; x++) {
+			if(slots[x].value) {
+				f(slots[x].value);
+			}
+		}
+	}
+	
+	inline std::size_t size() const {
+		return numEntries;
+	}
+	
+	///Number of bytes held by the table
+	inline std::size_t getBytes() const {
+		return slots ? (mask + 1) * sizeof(Slot) : 0;
+	}
+	
+	///Return true iff the next insert has to grow the table
+	inline bool isFull() const {
+		return !slots || 4 * (numEntries + 1) > 3 * (mask + 1);
+	}
+	
+	///Number of bytes the next insert adds to the table (0 unless it has to grow)
+	inline std::size_t getGrowth() const {
+		if(!isFull()) {
+			return 0;
+		}
+		return slots ? getBytes() : getMinBytes();
+	}
+	
+	///Number of bytes held by a table with a single value
+	static std::size_t getMinBytes() {
+		return MIN_CAPACITY * sizeof(Slot);
+	}
+};
+
+#endif
@@ -1,8 +1,8 @@
 #include "Filter.hpp"
 #include "Node.hpp"
+#include "FlatHashTable.hpp"
 #include <iostream>
 #include <functional>
-#include <unordered_map>
 #include <vector>
 
 #ifndef HASH_COMBINE_FUNCTION
@@ -16,27 +16,16 @@
 	}
 #endif
 
+//hash of the qubit map and the ready gates; the node keeps this up to date, so it costs the same on any device
 inline std::size_t hashFunc1(Node * n) {
-	std::size_t hash_result = 0;
-	int numQubits = n->env->numPhysicalQubits;
-	
-	//combine into hash: qubit map (array of integers)
-	for(int x = 0; x < numQubits; x++) {
-		hash_combine(hash_result, n->laq[x]);
-	}
-	
-	//combine into hash: ready gate (set of pointers)
-	for(auto x = n->readyGates.begin(); x != n->readyGates.end(); x++) {
-		hash_combine(hash_result, (std::uintptr_t) (*x));
-	}
-	
-	return hash_result;
+	return n->stateHash();
 }
 
 class HashFilter : public Filter {
   private:
 	int numFiltered = 0;
-	std::unordered_map<std::size_t, vector<Node*> > hashmap;
+	FlatHashTable<Node*> table;
+	std::vector<std::size_t> found;//slots of the nodes matching the hash we're looking at
 	
   public:
 	Filter * createEmptyCopy() {
@@ -47,27 +36,19 @@ class HashFilter : public Filter {
 	
 	void deleteRecord(Node * n) {
 		std::size_t hash_result = hashFunc1(n);
-		vector<Node*> * mapValue = &this->hashmap[hash_result];//Note: I'm terrified of accidentally making an actual copy of the vector here
-		for(unsigned int blah = 0; blah <  mapValue->size(); blah++) {
-			Node * n2 = (*mapValue)[blah];
-			if(n2 == n) {
-				if(mapValue->size() > 1 && blah < mapValue->size() - 1) {
-					std::swap((*mapValue)[blah],(*mapValue)[mapValue->size()-1]);
-				}
-				mapValue->pop_back();
-				return;
-			}
-		}
+		this->table.remove(hash_result, n, this->found);
 	}
 	
 	bool filter(Node * newNode) {
 		int numQubits = newNode->env->numPhysicalQubits;
 		std::size_t hash_result = hashFunc1(newNode);
 		
-		//auto findNode = this->hashmap.find(hash_result);
-		//if(findNode != this->hashmap.end()) {
-		for(Node * candidate : this->hashmap[hash_result]) {
-			//Node * candidate = findNode->second;
+		this->table.find(hash_result, this->found);
+		for(unsigned int y = 0; y < this->found.size(); y++) {
+			if(y + 1 < this->found.size()) {
+				this->table.prefetchNode(this->found[y + 1]);
+			}
+			Node * candidate = this->table.at(this->found[y]);
 			bool willFilter = true;
 			
 			for(int x = 0; x < numQubits; x++) {
@@ -77,17 +58,9 @@ class HashFilter : public Filter {
 					break;
 				}
 			}
-			if(newNode->readyGates.size() != candidate->readyGates.size()) {
+			if(willFilter && newNode->readyGates != candidate->readyGates) {
 				//std::cerr << "Warning: duplicate hash values.\n";
 				willFilter = false;
-			} else if(willFilter) {
-				for(auto x = newNode->readyGates.begin(), y = candidate->readyGates.begin(); x != newNode->readyGates.end(); x++, y++) {
-					if((*x) != (*y)) {
-						//std::cerr << "Warning: duplicate hash values.\n";
-						willFilter = false;
-						break;
-					}
-				}
 			}
 			bool allEqual = willFilter;
 			for(int x = 0; willFilter && x < numQubits; x++) {
@@ -120,7 +93,7 @@ class HashFilter : public Filter {
 				return true;
 			}
 		}
-		this->hashmap[hash_result].push_back(newNode);
+		this->table.insert(hash_result, newNode);
 		
 		return false;
 	}
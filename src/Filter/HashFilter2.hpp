@@ -1,8 +1,12 @@
 #include "Filter.hpp"
 #include "Node.hpp"
+#include "FlatHashTable.hpp"
+#include "BlockedBloomFilter.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <functional>
-#include <unordered_map>
 #include <vector>
 
 #ifndef HASH_COMBINE_FUNCTION
@@ -37,61 +41,161 @@ inline int catchUp(GateNode * ancestor, GateNode * descendant, int logQubit, int
 	return cycles;
 }
 
-inline std::size_t hashFunc2(Node * n) {
-	std::size_t hash_result = 0;
-	int numQubits = n->env->numPhysicalQubits;
-	
-	//combine into hash: qubit map (array of integers)
-	for(int x = 0; x < numQubits; x+=4) {
-		unsigned int sum = 0;
-		for(int y = 0; y < 4 && (x + y) < numQubits; y++) {
-			sum = sum << 8;
-			sum += 0xff & n->laq[x + y];
+/**
+ * Compares each new node to the recorded nodes with the same qubit mapping, at any cycle;
+	it filters the new node if one of them dominates it, and marks dead the ones it dominates.
+ * Nodes are indexed in two levels: a group per exact qubit mapping (found through mappingHash),
+	then within each group, sorted by progress (number of unscheduled gates) and then by cycle.
+ * A node that dominates another can only be behind it on a qubit if it started less than swapCost cycles earlier,
+	and then only by gates it catches up on within swapCost cycles (see catchUp).
+	So for each level of progress, only a range of cycles can hold a node to filter the new one by or to mark dead,
+	and we look up that range by binary search instead of scanning the level.
+ */
+class HashFilter2 : public Filter {
+  private:
+	//a node in a group, along with the keys it's sorted on (so searching a group doesn't touch the nodes)
+	struct Entry {
+		int unscheduled;//numUnscheduledGates
+		int cycle;
+		Node * node;
+		
+		Entry(Node * n) : unscheduled(n->numUnscheduledGates), cycle(n->cycle), node(n) {
 		}
-		hash_combine(hash_result, sum);
 		
-		hash_combine(hash_result, n->qal[x]);//added this to try to discourage hash conflict
-	}
-	
-	//Note: this line may avoid hash conflicts in some benchmarks?
-	//if(numQubits > 4) hash_combine(hash_result, (int)(n->laq[1]+1)*(int)(n->laq[2]+1)*(int)(n->laq[3]+1)*((int)n->laq[4]+1));
+		inline bool operator<(const Entry & other) const {
+			return unscheduled < other.unscheduled || (unscheduled == other.unscheduled && cycle < other.cycle);
+		}
+	};
 	
-	//adding part of cycle to hash means we filter fewer nodes, but the filter runs much faster:
-	hash_combine(hash_result, n->cycle >> 3);
+	struct MappingGroup {
+		std::vector<Entry> entries;//sorted by number of unscheduled gates, then by cycle; never empty
+	};
 	
-	return hash_result;
-}
-
-class HashFilter2 : public Filter {
-  private:
 	int numFiltered = 0;
 	int numMarkedDead = 0;
-	bool foundConflict = false;
-	std::unordered_map<std::size_t, vector<Node*> > hashmap;
+	long numCompared = 0;//pairs of nodes we ran the full comparison on
+	long numSkipped = 0;//nodes we didn't compare to, though they shared the new node's mapping
+	FlatHashTable<MappingGroup*> table;//keyed on mappingHash
+	std::vector<std::size_t> found;//slots of the groups matching the hash we're looking at
+	
+	//most gates a node can be behind, on one qubit, a node that dominates it; -1 until we see the first node
+	int qubitSlack = -1;
+	
+	int findQubitSlack(Environment * env) {
+		int minLatency = INT_MAX;
+		for(GateNode * g : GateNode::gates) {
+			if(!g->isSwap && g->optimisticLatency < minLatency) {
+				minLatency = g->optimisticLatency;
+			}
+		}
+		if(minLatency <= 0) {
+			//zero-latency gates take no time to catch up on, so any number of them could be behind:
+			return env->numGates;
+		}
+		return std::min(env->numGates, (env->swapCost - 1) / minLatency);
+	}
+	
+	//Find the group with n's exact mapping (null if there's none); leaves found holding the slots with n's mappingHash
+	MappingGroup * findGroup(Node * n) {
+		this->table.find(n->mappingHash, this->found);
+		for(std::size_t slot : this->found) {
+			MappingGroup * group = this->table.at(slot);
+			if(!std::memcmp(group->entries[0].node->qal, n->qal, n->env->numPhysicalQubits * sizeof(qubit_t))) {
+				return group;
+			}
+		}
+		return 0;
+	}
+	
+	void removeGroup(MappingGroup * group, std::size_t hash) {
+		this->table.remove(hash, group, this->found);
+		delete group;
+	}
+	
+	//Optional prefilter: a node whose hash the Bloom filter has never seen can't be compared to anything,
+	//so we skip the table lookup. We rebuild it from the table whenever it fills up, dropping removed groups' hashes.
+	bool useBloom;
+	BlockedBloomFilter bloom;
+	std::size_t bloomCapacity = 0;
+	std::size_t numBloomInserts = 0;//since the last rebuild
+	long numDefinitelyNew = 0;
+	long numFalsePositives = 0;//nodes the Bloom filter let through even though the table had nothing with their hash
+	
+	void rebuildBloom() {
+		bloomCapacity = std::max((std::size_t) 1024, 2 * this->table.size());
+		this->bloom.reset(bloomCapacity);
+		numBloomInserts = this->table.size();
+		this->table.forEachHash([this](std::size_t hash) {
+			this->bloom.insert(hash);
+		});
+	}
+	
+	//Add n to its mapping's group, or start a group for it if that's null
+	void record(MappingGroup * group, Node * n) {
+		if(group) {
+			Entry entry(n);
+			group->entries.insert(std::upper_bound(group->entries.begin(), group->entries.end(), entry), entry);
+			return;
+		}
+		
+		group = new MappingGroup();
+		group->entries.push_back(Entry(n));
+		std::size_t hash = n->mappingHash;
+		this->table.insert(hash, group);
+		if(this->useBloom) {
+			if(++numBloomInserts > bloomCapacity) {
+				rebuildBloom();
+			} else {
+				this->bloom.insert(hash);
+			}
+		}
+	}
 	
   public:
+	///Iff useBloom, look up each node's hash in a blocked Bloom filter before searching the table for nodes to compare it to
+	HashFilter2(bool useBloom = false) {
+		this->useBloom = useBloom;
+		if(useBloom) {
+			rebuildBloom();
+		}
+	}
+	
+	~HashFilter2() {
+		this->table.forEachValue([](MappingGroup * group) {
+			delete group;
+		});
+	}
+	
 	Filter * createEmptyCopy() {
-		HashFilter2 * f = new HashFilter2();
+		HashFilter2 * f = new HashFilter2(this->useBloom);
 		f->numFiltered = this->numFiltered;
 		f->numMarkedDead = this->numMarkedDead;
+		f->numCompared = this->numCompared;
+		f->numSkipped = this->numSkipped;
+		f->numDefinitelyNew = this->numDefinitelyNew;
+		f->numFalsePositives = this->numFalsePositives;
 		return f;
 	}
 	
 	void deleteRecord(Node * n) {
-		std::size_t hash_result = hashFunc2(n);
-		vector<Node*> * mapValue = &this->hashmap[hash_result];//Note: I'm terrified of accidentally making an actual copy of the vector here, hence the awkward pointers
-		//assert(mapValue->size() > 0);
-		for(unsigned int blah = 0; blah <  mapValue->size(); blah++) {
-			Node * n2 = (*mapValue)[blah];
-			if(n2 == n) {
-				if(mapValue->size() > 1 && blah < mapValue->size() - 1) {
-					std::swap((*mapValue)[blah],(*mapValue)[mapValue->size()-1]);
-				}
-				mapValue->pop_back();
-				return;
-			}
+		MappingGroup * group = findGroup(n);
+		if(!group) {
+			return;
+		}
+		std::vector<Entry> & entries = group->entries;
+		Entry key(n);
+		std::vector<Entry>::iterator x = std::lower_bound(entries.begin(), entries.end(), key);
+		while(x != entries.end() && x->node != n && !(key < *x)) {
+			x++;
+		}
+		if(x == entries.end() || x->node != n) {
+			//assert(false && "hashfilter2 failed to find node to delete");
+			return;
+		}
+		entries.erase(x);
+		if(entries.empty()) {
+			removeGroup(group, n->mappingHash);
 		}
-		//assert(false && "hashfilter2 failed to find node to delete");
 	}
 	
 	bool filter(Node * newNode) {
@@ -101,223 +205,270 @@ class HashFilter2 : public Filter {
 		
 		int numQubits = newNode->env->numPhysicalQubits;
 		
-		std::size_t hash_result = hashFunc2(newNode);
-		
 		int swapCost = newNode->env->swapCost;
-		vector<Node*> * mapValue = &this->hashmap[hash_result];//Note: I'm terrified of accidentally making an actual copy of the vector here
-		for(unsigned int blah = mapValue->size() - 1; blah < mapValue->size() && blah >= 0; blah--) {
-			Node * candidate = (*mapValue)[blah];
-			
-			//if there's a very big gap between nodes' progress then we probably won't benefit from comparing them:
-			//if(candidate->cycle - newNode->cycle >= 6 || newNode->cycle - candidate->cycle >= 6) {
-			//	continue;
-			//}
-			
-			if(candidate->dead) {
-				continue;
-			} //else if(candidate->parent && candidate->parent->dead) {
-			//	candidate->dead = true;
-			//}
-			
-			bool willFilter = candidate->cycle <= newNode->cycle;
-			bool willMarkDead = newNode->cycle <= candidate->cycle;
-			bool canMarkDead = false;
-			
-			int cycleDiff = newNode->cycle - candidate->cycle;
-			if(cycleDiff < 0) {
-				cycleDiff = -cycleDiff;
-			}
-			
-			///*
-			//check for simple descendant relationship (without additional gates)
-			if(newNode->scheduled == candidate->scheduled) {
-				willFilter = false;
-				willMarkDead = false;
-			}
-			//*/
-			/*
-			//check for descendant relationship
-			Node * tempNode = newNode;
-			while(tempNode->cycle > candidate->cycle) {
-				tempNode = tempNode->parent;
+		if(this->qubitSlack < 0) {
+			this->qubitSlack = findQubitSlack(newNode->env);
+		}
+		if(this->useBloom) {
+			if(!this->bloom.mayContain(newNode->mappingHash)) {
+				numDefinitelyNew++;
+				record(0, newNode);
+				return false;
 			}
-			if(tempNode == candidate) {
-				willFilter = false;
-				willMarkDead = false;
+		}
+		MappingGroup * group = findGroup(newNode);
+		if(!group) {
+			if(this->useBloom && this->found.empty()) {
+				numFalsePositives++;
 			}
-			//*/
-			
-			if(willFilter || willMarkDead) {
-				if(this->foundConflict || blah == mapValue->size() - 1) {
-					bool conflict = false;
-					for(int x = 0; x < numQubits - 1; x++) {
-						if(candidate->laq[x] != newNode->laq[x]) {
-							if(!this->foundConflict) {
-								std::cerr << "//WARNING: hash conflict detected.\n";
-								this->foundConflict = true;
-							}
-							willFilter = false;
-							conflict = true;
-							break;
+			record(0, newNode);
+			return false;
+		}
+		
+		//which cycles can hold a node that filters newNode or that newNode marks dead, at each level of progress:
+		int unscheduledGates = newNode->numUnscheduledGates;
+		int cycle = newNode->cycle;
+		int aheadSlack = newNode->env->numLogicalQubits * this->qubitSlack;//most gates a node newNode marks dead can be ahead of it
+		int behindSlack = -1;//most gates a node that filters newNode can be behind it; we work it out when we need it
+		
+		//go from the least progress to the most, latest cycle first, since the newest nodes are the likeliest to be in the cache:
+		std::vector<Entry> & entries = group->entries;
+		std::size_t levelEnd = entries.size();
+		while(levelEnd > 0) {
+			//the entries in [levelStart, levelEnd) have the same number of unscheduled gates, sorted by cycle:
+			int unscheduled = entries[levelEnd - 1].unscheduled;
+			std::size_t levelStart = std::lower_bound(entries.begin(), entries.begin() + levelEnd, unscheduled,
+					[](const Entry & e, int u) { return e.unscheduled < u; }) - entries.begin();
+			int minCycle = INT_MIN;
+			int maxCycle = INT_MAX;
+			if(unscheduled < unscheduledGates - aheadSlack) {
+				maxCycle = cycle;//too far ahead to be marked dead
+			} else if(unscheduled < unscheduledGates) {
+				maxCycle = cycle + swapCost - 1;//newNode has to catch up within swapCost cycles to mark it dead
+			} else if(unscheduled > unscheduledGates) {
+				if(behindSlack < 0) {
+					//a node can only be behind newNode on the qubits newNode is busy with:
+					behindSlack = 0;
+					for(int x = 0; x < newNode->env->numLogicalQubits; x++) {
+						int qubit = newNode->laq[x];
+						if(qubit >= 0 && newNode->busyCycles(qubit) > 1) {
+							behindSlack += this->qubitSlack;
 						}
 					}
-					if(conflict) {
-						continue;
-					}
+				}
+				if(unscheduled > unscheduledGates + behindSlack) {
+					minCycle = cycle;//too far behind to filter newNode
+				} else {
+					minCycle = cycle - swapCost + 1;//it has to catch up within swapCost cycles to filter newNode
 				}
 			}
+			std::size_t first = std::lower_bound(entries.begin() + levelStart, entries.begin() + levelEnd, minCycle,
+					[](const Entry & e, int c) { return e.cycle < c; }) - entries.begin();
+			std::size_t last = std::upper_bound(entries.begin() + levelStart, entries.begin() + levelEnd, maxCycle,
+					[](int c, const Entry & e) { return c < e.cycle; }) - entries.begin();
+			numSkipped += (levelEnd - levelStart) - (last - first);
+			levelEnd = levelStart;
 			
-			//set willFilter and willMarkDead to false as appropriate based on qubit progress
-			for(int x = 0; (willFilter || willMarkDead) && x < numQubits; x++) {
-				ScheduledGate * lastCanGate = candidate->lastNonSwapGate[x];
-				ScheduledGate * lastNewGate = newNode->lastNonSwapGate[x];
-				int qubit = newNode->laq[x];//physical qubit containing logical qubit x
-				int canBusy = 0;
-				int newBusy = 0;
-				if(qubit >= 0) {
-					canBusy = candidate->busyCycles(qubit);
-					newBusy = newNode->busyCycles(qubit);
+			for(std::size_t blah = last; blah-- > first; ) {
+				if(blah > first) {
+					__builtin_prefetch(entries[blah - 1].node);
+					__builtin_prefetch(entries[blah - 1].node->storage());
+				}
+				Node * candidate = entries[blah].node;
+				numCompared++;
+				
+				//if there's a very big gap between nodes' progress then we probably won't benefit from comparing them:
+				//if(candidate->cycle - newNode->cycle >= 6 || newNode->cycle - candidate->cycle >= 6) {
+				//	continue;
+				//}
+				
+				if(candidate->dead) {
+					continue;
+				} //else if(candidate->parent && candidate->parent->dead) {
+				//	candidate->dead = true;
+				//}
+				
+				bool willFilter = candidate->cycle <= newNode->cycle;
+				bool willMarkDead = newNode->cycle <= candidate->cycle;
+				bool canMarkDead = false;
+				
+				int cycleDiff = newNode->cycle - candidate->cycle;
+				if(cycleDiff < 0) {
+					cycleDiff = -cycleDiff;
 				}
-				if(lastNewGate && !lastCanGate) {//newNode has scheduled gates that candidate hasn't scheduled
-					//ToDo can maybe avoid setting to false here if candidate has made more progress on a high-latency swap?
+				
+				///*
+				//check for simple descendant relationship (without additional gates)
+				if(newNode->scheduled == candidate->scheduled) {
 					willFilter = false;
-					canMarkDead = true;
-					//ToDo can probably be more selective here too:
-					if(newBusy > 1 && candidate->cycle + canBusy < newNode->cycle + newBusy) {
-						willMarkDead = false;
-					}
-				} else if(lastCanGate && !lastNewGate) {//candidate has more scheduled gates for this qubit
-					//ToDo can maybe avoid setting to false here if newNode has made more progress on a high-latency swap?
 					willMarkDead = false;
-					//ToDo can probably be more selective here too:
-					if(canBusy > 1 && newNode->cycle + newBusy < candidate->cycle + canBusy) {
-						willFilter = false;
+				}
+				//*/
+				/*
+				//check for descendant relationship
+				Node * tempNode = newNode;
+				while(tempNode->cycle > candidate->cycle) {
+					tempNode = tempNode->parent;
+				}
+				if(tempNode == candidate) {
+					willFilter = false;
+					willMarkDead = false;
+				}
+				//*/
+				
+				//set willFilter and willMarkDead to false as appropriate based on qubit progress
+				for(int x = 0; (willFilter || willMarkDead) && x < numQubits; x++) {
+					ScheduledGate * lastCanGate = candidate->lastNonSwapGate[x];
+					ScheduledGate * lastNewGate = newNode->lastNonSwapGate[x];
+					int qubit = newNode->laq[x];//physical qubit containing logical qubit x
+					int canBusy = 0;
+					int newBusy = 0;
+					if(qubit >= 0) {
+						canBusy = candidate->busyCycles(qubit);
+						newBusy = newNode->busyCycles(qubit);
 					}
-				} else if((lastCanGate && lastNewGate) || (!lastCanGate && !lastNewGate)) {
-					if(!lastCanGate || lastCanGate->gate == lastNewGate->gate) {//same (un)scheduled gates for this qubit
-						//compare busyness
-						if(qubit >= 0) {
-							if((willFilter || !canMarkDead) && canBusy > 1) {
-								if(newBusy) {//both nodes are busy
-									int candidateCycle = canBusy + candidate->cycle;
-									int newCycle = newBusy + newNode->cycle;
-									if(candidateCycle > newCycle) {
+					if(lastNewGate && !lastCanGate) {//newNode has scheduled gates that candidate hasn't scheduled
+						//ToDo can maybe avoid setting to false here if candidate has made more progress on a high-latency swap?
+						willFilter = false;
+						canMarkDead = true;
+						//ToDo can probably be more selective here too:
+						if(newBusy > 1 && candidate->cycle + canBusy < newNode->cycle + newBusy) {
+							willMarkDead = false;
+						}
+					} else if(lastCanGate && !lastNewGate) {//candidate has more scheduled gates for this qubit
+						//ToDo can maybe avoid setting to false here if newNode has made more progress on a high-latency swap?
+						willMarkDead = false;
+						//ToDo can probably be more selective here too:
+						if(canBusy > 1 && newNode->cycle + newBusy < candidate->cycle + canBusy) {
+							willFilter = false;
+						}
+					} else if((lastCanGate && lastNewGate) || (!lastCanGate && !lastNewGate)) {
+						if(!lastCanGate || lastCanGate->gate() == lastNewGate->gate()) {//same (un)scheduled gates for this qubit
+							//compare busyness
+							if(qubit >= 0) {
+								if((willFilter || !canMarkDead) && canBusy > 1) {
+									if(newBusy) {//both nodes are busy
+										int candidateCycle = canBusy + candidate->cycle;
+										int newCycle = newBusy + newNode->cycle;
+										if(candidateCycle > newCycle) {
+											willFilter = false;
+											canMarkDead = true;
+										}
+									} else {//only candidate is busy
+										int candidateCycle = canBusy + candidate->cycle;
+										if(candidateCycle > newNode->cycle) {
+											willFilter = false;
+											canMarkDead = true;
+										}
+									}
+								}
+								if(willMarkDead && newBusy > 1) {
+									if(canBusy) {//both nodes are busy
+										int candidateCycle = canBusy + candidate->cycle;
+										int newCycle = newBusy + newNode->cycle;
+										if(newCycle > candidateCycle) {
+											willMarkDead = false;
+										}
+									} else {//only newNode is busy
+										int newCycle = newBusy + newNode->cycle;
+										if(newCycle > candidate->cycle) {
+											willMarkDead = false;
+										}
+									}
+								}
+							}
+						} else if(lastCanGate->gate()->criticality > lastNewGate->gate()->criticality) {//newNode has scheduled gates candidate hasn't
+							if(willFilter && (newBusy <= 1 || newBusy <= canBusy || newNode->cycle - candidate->cycle >= swapCost)) {
+								willFilter = false;
+								canMarkDead = true;
+							} else {
+								///*
+								int catchup = catchUp(lastCanGate->gate(), lastNewGate->gate(), x, swapCost+1);
+								//if(willFilter) {
+									if(catchup + newNode->cycle + newBusy > candidate->cycle + canBusy) {
 										willFilter = false;
 										canMarkDead = true;
-									}
-								} else {//only candidate is busy
-									int candidateCycle = canBusy + candidate->cycle;
-									if(candidateCycle > newNode->cycle) {
+									} else if(catchup >= swapCost) {
 										willFilter = false;
 										canMarkDead = true;
 									}
+								//}
+								if(willMarkDead) {
+									if(catchup <= swapCost) {
+										if(catchup + candidate->cycle + canBusy <= newNode->cycle + newBusy) {
+											willMarkDead = false;
+										}
+									}
 								}
+								//*/
+								/*
+								willFilter = false;
+								if(canBusy < newBusy) {
+									willMarkDead = false;
+								}
+								//*/
 							}
-							if(willMarkDead && newBusy > 1) {
-								if(canBusy) {//both nodes are busy
-									int candidateCycle = canBusy + candidate->cycle;
-									int newCycle = newBusy + newNode->cycle;
-									if(newCycle > candidateCycle) {
+						} else if(lastCanGate->gate()->criticality < lastNewGate->gate()->criticality) {//candidate has more scheduled gates for this qubit
+							if(willMarkDead && (canBusy <= 1 || canBusy <= newBusy || candidate->cycle - newNode->cycle >= swapCost)) {
+								willMarkDead = false;
+							} else {
+								///*
+								int catchup = catchUp(lastNewGate->gate(), lastCanGate->gate(), x, swapCost+1);
+								if(willMarkDead) {
+									if(catchup + candidate->cycle + canBusy > newNode->cycle + newBusy) {
 										willMarkDead = false;
-									}
-								} else {//only newNode is busy
-									int newCycle = newBusy + newNode->cycle;
-									if(newCycle > candidate->cycle) {
+									} else if(catchup >= swapCost) {
 										willMarkDead = false;
 									}
 								}
-							}
-						}
-					} else if(lastCanGate->gate->criticality > lastNewGate->gate->criticality) {//newNode has scheduled gates candidate hasn't
-						if(willFilter && (newBusy <= 1 || newBusy <= canBusy || newNode->cycle - candidate->cycle >= swapCost)) {
-							willFilter = false;
-							canMarkDead = true;
-						} else {
-							///*
-							int catchup = catchUp(lastCanGate->gate, lastNewGate->gate, x, swapCost+1);
-							//if(willFilter) {
-								if(catchup + newNode->cycle + newBusy > candidate->cycle + canBusy) {
-									willFilter = false;
-									canMarkDead = true;
-								} else if(catchup >= swapCost) {
-									willFilter = false;
-									canMarkDead = true;
-								}
-							//}
-							if(willMarkDead) {
-								if(catchup <= swapCost) {
-									if(catchup + candidate->cycle + canBusy <= newNode->cycle + newBusy) {
-										willMarkDead = false;
+								//if(willFilter) {
+									if(catchup <= swapCost) {
+										if(catchup + newNode->cycle + newBusy <= candidate->cycle + canBusy) {
+											willFilter = false;
+											canMarkDead = true;
+										}
 									}
+								//}
+								//*/
+								/*
+								if(newBusy < canBusy) {
+									willFilter = false;
 								}
-							}
-							//*/
-							/*
-							willFilter = false;
-							if(canBusy < newBusy) {
 								willMarkDead = false;
+								//*/
 							}
-							//*/
-						}
-					} else if(lastCanGate->gate->criticality < lastNewGate->gate->criticality) {//candidate has more scheduled gates for this qubit
-						if(willMarkDead && (canBusy <= 1 || canBusy <= newBusy || candidate->cycle - newNode->cycle >= swapCost)) {
-							willMarkDead = false;
 						} else {
-							///*
-							int catchup = catchUp(lastNewGate->gate, lastCanGate->gate, x, swapCost+1);
-							if(willMarkDead) {
-								if(catchup + candidate->cycle + canBusy > newNode->cycle + newBusy) {
-									willMarkDead = false;
-								} else if(catchup >= swapCost) {
-									willMarkDead = false;
-								}
-							}
-							//if(willFilter) {
-								if(catchup <= swapCost) {
-									if(catchup + newNode->cycle + newBusy <= candidate->cycle + canBusy) {
-										willFilter = false;
-										canMarkDead = true;
-									}
-								}
-							//}
-							//*/
-							/*
-							if(newBusy < canBusy) {
-								willFilter = false;
-							}
-							willMarkDead = false;
-							//*/
+							assert(false);
 						}
 					} else {
 						assert(false);
 					}
-				} else {
-					assert(false);
 				}
-			}
-			
-			if(!canMarkDead || willFilter) {
-				willMarkDead = false;
-			}
-			if(willMarkDead) {
-				candidate->dead = true;
-				numMarkedDead++;
-			}
-			
-			//remove dead node from vector
-			if(candidate->dead) {
-				if(mapValue->size() > 1 && blah < mapValue->size() - 1) {
-					std::swap((*mapValue)[blah],(*mapValue)[mapValue->size()-1]);
+				
+				if(!canMarkDead || willFilter) {
+					willMarkDead = false;
+				}
+				if(willMarkDead) {
+					candidate->dead = true;
+					numMarkedDead++;
+				}
+				
+				//remove dead node from table
+				if(candidate->dead) {
+					entries.erase(entries.begin() + blah);
+				}
+				
+				if(willFilter) {
+					numFiltered++;
+					return true;
 				}
-				mapValue->pop_back();
-			}
-			
-			if(willFilter) {
-				numFiltered++;
-				return true;
 			}
 		}
-		mapValue->push_back(newNode);
+		if(entries.empty()) {
+			removeGroup(group, newNode->mappingHash);
+			group = 0;
+		}
+		record(group, newNode);
 		
 		return false;
 	}
@@ -325,5 +476,15 @@ class HashFilter2 : public Filter {
 	virtual void printStatistics(std::ostream & stream) {
 		stream << "//HashFilter2 filtered " << numFiltered << " total nodes.\n";
 		stream << "//HashFilter2 marked " << numMarkedDead << " total nodes.\n";
+		stream << "//HashFilter2 ran " << numCompared << " comparisons, and its index skipped " << numSkipped << " more nodes with the same mapping.\n";
+		if(this->useBloom) {
+			long numNew = numDefinitelyNew + numFalsePositives;
+			stream << "//HashFilter2 Bloom filter skipped the table for " << numDefinitelyNew << " nodes; false positive rate " << (numNew ? 100.0 * numFalsePositives / numNew : 0.0) << "% (" << numFalsePositives << " of " << numNew << " unseen hashes).\n";
+			std::size_t tableBytes = this->table.getBytes();
+			this->table.forEachValue([&tableBytes](MappingGroup * group) {
+				tableBytes += sizeof(MappingGroup) + group->entries.capacity() * sizeof(Entry);
+			});
+			stream << "//HashFilter2 Bloom filter takes " << this->bloom.getBytes() << " bytes; the table takes " << tableBytes << " bytes.\n";
+		}
 	}
 };
@@ -6,12 +6,13 @@
 #include "SimpleFilter.hpp"
 #include "HashFilter.hpp"
 #include "HashFilter2.hpp"
+#include "SignatureFilter.hpp"
 #include "AlternatingFilter.hpp"
 #include <string>
 #include <tuple>
 using namespace std;
 
-const int NUMFILTERS = 2;
+const int NUMFILTERS = 5;
 tuple<Filter*, string, string> FILTERS[NUMFILTERS] = {
 	make_tuple(new HashFilter(),
 				"HashFilter",
@@ -19,6 +20,15 @@ tuple<Filter*, string, string> FILTERS[NUMFILTERS] = {
 	make_tuple(new HashFilter2(),
 				"HashFilter2",
 				"using hash, this tries to filter out worse nodes, or mark old nodes as dead if a new node is strictly-better."),
+	make_tuple(new HashFilter2(true),
+				"BloomHashFilter2",
+				"HashFilter2 with a blocked Bloom filter in front, so nodes with a never-seen hash skip the table lookup."),
+	make_tuple(new SignatureFilter(),
+				"SignatureFilter",
+				"filters out nodes no better than an earlier node at the same cycle, comparing compact state signatures (so popped nodes can be freed right away)."),
+	make_tuple(new SignatureFilter(true),
+				"BoundedSignatureFilter",
+				"Takes 2 params (memory cap in bytes with optional K/M/G suffix, then cycle window or 0); SignatureFilter that forgets its oldest signatures to stay within them."),
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,410 @@
+#include "Filter.hpp"
+#include "Node.hpp"
+#include "FlatHashTable.hpp"
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * This filter keeps a compact signature of every node it lets through, instead of a pointer to the node:
+	the cycle, the qubit mapping, the ready gates, and how many more cycles each physical qubit is busy.
+ * It filters a new node if some earlier node at the same cycle had the same mapping and ready gates,
+	with no qubit busy for longer.
+	(Comparing nodes at different cycles isn't safe here: two nodes could each be the reason the other's idle child gets filtered.)
+ * Since the signatures don't refer to the nodes, main can free each node right after expanding it.
+ * As BoundedSignatureFilter, it takes 2 params: a memory cap (bytes, with an optional K/M/G suffix),
+	and a cycle window (or 0 for none).
+	Signatures are stored oldest first in fixed-size chunks (sized from the cap, 1/16 of it but between 16K and 1M);
+	it forgets the oldest chunk while there's no room under the cap for one more chunk, or for the hash table to grow,
+	or while every signature in it is more than the window behind the latest cycle it has seen.
+	So its memory (chunks plus table) never exceeds the cap; caps too small for two chunks and the smallest table are rejected.
+	A signature that filters a node while in the oldest chunk is copied to the newest one instead (like a CLOCK cache's second chance).
+	Forgetting signatures only means filtering fewer nodes, so the search stays optimal.
+ */
+class SignatureFilter : public Filter {
+  private:
+	static const int MIN_CHUNK_SHIFT = 12;
+	static const int MAX_CHUNK_SHIFT = 18;
+	int chunkShift = MAX_CHUNK_SHIFT;//signatures are stored in chunks of 2^chunkShift 32-bit words
+	uint64_t chunkWords = 1u << MAX_CHUNK_SHIFT;
+	
+	struct Chunk {
+		uint32_t * words;
+		unsigned int fill;//number of words used so far
+		int maxCycle;//latest cycle of a signature in this chunk
+	};
+	
+	//Signature layout (in 32-bit words): cycle, number of ready gates, their ids,
+	//then the logical qubit at each physical qubit (two per word), then the busy cycles of each physical qubit (two per word).
+	std::deque<Chunk> chunks;
+	uint64_t firstChunk = 0;//chunk number (offset >> chunkShift) of chunks.front()
+	uint64_t used = 0;//offset of the next signature; a signature never straddles two chunks
+	uint32_t * spareChunk = 0;//the last chunk we forgot, kept for reuse
+	FlatHashTable<uint64_t> table;//values are signature offsets plus one (so 0 means empty)
+	std::vector<std::size_t> found;//slots of the signatures matching the key we're looking at
+	int numQubits = 0;
+	
+	bool bounded;
+	long long maxBytes = 1LL << 30;
+	int cycleWindow = 0;
+	int latestCycle = INT_MIN;//latest cycle of a node we've been asked to filter
+	
+	int numFiltered = 0;
+	int numReplaced = 0;//signatures dropped because a new node did at least as well
+	long numSignatures = 0;
+	long numLookups = 0;
+	long numEvicted = 0;//signatures forgotten along with their chunk
+	long numSecondChances = 0;//signatures copied out of the oldest chunk
+	
+	inline Chunk & chunkOf(uint64_t offset) {
+		return chunks[(offset >> chunkShift) - firstChunk];
+	}
+	
+	inline uint32_t * signature(uint64_t offset) {
+		return chunkOf(offset).words + (offset & (chunkWords - 1));
+	}
+	
+	inline std::size_t key(Node * n) {
+		return n->stateHash() ^ Node::mix64((uint64_t) (uint32_t) n->cycle << 40);
+	}
+	
+	//the key of the node a signature came from
+	std::size_t key(const uint32_t * sig) {
+		uint64_t hash = 0;
+		const uint32_t * word = sig + 2;
+		for(unsigned int x = 0; x < sig[1]; x++) {
+			hash ^= Node::gateKey(*word++);
+		}
+		const uint16_t * qal = (const uint16_t*) word;
+		for(int x = 0; x < numQubits; x++) {
+			if((int16_t) qal[x] >= 0) {
+				hash ^= Node::qubitKey(x, (int16_t) qal[x]);
+			}
+		}
+		return hash ^ Node::mix64((uint64_t) sig[0] << 40);
+	}
+	
+	inline unsigned int numWords(unsigned int numReady) {
+		return 2 + numReady + 2 * ((numQubits + 1) / 2);
+	}
+	
+	inline std::size_t getChunkBytes() {
+		return chunkWords * sizeof(uint32_t);
+	}
+	
+	//counting the chunk we keep for reuse
+	inline std::size_t getBytes() {
+		return (chunks.size() + (spareChunk ? 1 : 0)) * getChunkBytes() + this->table.getBytes();
+	}
+	
+	//Returns a pointer to the busy cycles in sig if it has the same cycle, mapping, and ready gates as n, or NULL otherwise
+	const uint16_t * sameState(const uint32_t * sig, Node * n) {
+		if((int) sig[0] != n->cycle || (int) sig[1] != n->readyGates.size()) {
+			return 0;
+		}
+		const uint32_t * word = sig + 2;
+		for(GateNode * g : n->readyGates) {
+			if(*word++ != g->id) {
+				return 0;
+			}
+		}
+		const uint16_t * qal = (const uint16_t*) word;
+		for(int x = 0; x < numQubits; x++) {
+			if(qal[x] != (uint16_t) n->qal[x]) {
+				return 0;
+			}
+		}
+		return (const uint16_t*) (word + (numQubits + 1) / 2);
+	}
+	
+	//Reserve space for a signature of the specified size and return its offset
+	uint64_t allocate(unsigned int size, int cycle) {
+		if((used & (chunkWords - 1)) + size > chunkWords) {
+			//skip the rest of this chunk
+			used = ((used >> chunkShift) + 1) << chunkShift;
+		}
+		if((used >> chunkShift) >= firstChunk + chunks.size()) {
+			Chunk c;
+			c.words = spareChunk ? spareChunk : new uint32_t[chunkWords];
+			c.fill = 0;
+			c.maxCycle = INT_MIN;
+			spareChunk = 0;
+			if(chunks.empty()) {
+				firstChunk = used >> chunkShift;
+			}
+			chunks.push_back(c);
+		}
+		uint64_t offset = used;
+		used += size;
+		
+		Chunk & c = chunkOf(offset);
+		c.fill = (offset & (chunkWords - 1)) + size;
+		if(cycle > c.maxCycle) {
+			c.maxCycle = cycle;
+		}
+		numSignatures++;
+		return offset;
+	}
+	
+	//Append n's signature and return its offset
+	uint64_t store(Node * n) {
+		uint64_t offset = allocate(numWords(n->readyGates.size()), n->cycle);
+		uint32_t * sig = signature(offset);
+		sig[0] = n->cycle;
+		sig[1] = n->readyGates.size();
+		uint32_t * word = sig + 2;
+		for(GateNode * g : n->readyGates) {
+			*word++ = g->id;
+		}
+		uint16_t * qal = (uint16_t*) word;
+		uint16_t * busy = (uint16_t*) (word + (numQubits + 1) / 2);
+		for(int x = 0; x < numQubits; x++) {
+			qal[x] = n->qal[x];
+			busy[x] = n->busyCycles(x);
+		}
+		if(numQubits % 2) {
+			qal[numQubits] = 0;
+			busy[numQubits] = 0;
+		}
+		return offset;
+	}
+	
+	//Forget every signature in the oldest chunk
+	void evictOldestChunk() {
+		Chunk c = chunks.front();
+		uint64_t base = firstChunk << chunkShift;
+		for(unsigned int x = 0; x < c.fill; x += numWords(c.words[x + 1])) {
+			//signatures we dropped or copied already aren't in the table anymore:
+			if(this->table.remove(key(c.words + x), base + x + 1, this->found)) {
+				numSignatures--;
+				numEvicted++;
+			}
+		}
+		chunks.pop_front();
+		firstChunk++;
+		delete [] spareChunk;
+		spareChunk = c.words;
+		if(chunks.empty() && (used >> chunkShift) < firstChunk) {
+			//we forgot the chunk we were filling, so start the next one
+			used = firstChunk << chunkShift;
+		}
+	}
+	
+	//Forget old chunks until there's room under the cap for what storing one more signature may take:
+	//a new chunk, and a bigger table
+	void evict() {
+		while(!chunks.empty()) {
+			bool tooOld = cycleWindow > 0 && chunks.front().maxCycle < latestCycle - cycleWindow;
+			std::size_t newChunk = spareChunk ? 0 : getChunkBytes();
+			if(!tooOld && (long long) (getBytes() + newChunk + this->table.getGrowth()) <= maxBytes) {
+				break;
+			}
+			evictOldestChunk();
+		}
+	}
+	
+	bool parseMaxBytes(const char * str) {
+		char * end;
+		maxBytes = std::strtoll(str, &end, 10);
+		if(*end == 'k' || *end == 'K') {
+			maxBytes <<= 10;
+			end++;
+		} else if(*end == 'm' || *end == 'M') {
+			maxBytes <<= 20;
+			end++;
+		} else if(*end == 'g' || *end == 'G') {
+			maxBytes <<= 30;
+			end++;
+		}
+		if(end == str || *end || maxBytes <= 0) {
+			return false;
+		}
+		
+		//chunks of about 1/16 of the cap, so each eviction forgets a small part of what we know
+		chunkShift = MIN_CHUNK_SHIFT;
+		while(chunkShift < MAX_CHUNK_SHIFT && (long long) (sizeof(uint32_t) << (chunkShift + 1)) * 16 <= maxBytes) {
+			chunkShift++;
+		}
+		chunkWords = (uint64_t) 1 << chunkShift;
+		
+		long long minBytes = 2 * getChunkBytes() + FlatHashTable<uint64_t>::getMinBytes();
+		if(maxBytes < minBytes) {
+			std::cerr << "FATAL ERROR: BoundedSignatureFilter's memory cap must be at least " << minBytes << " bytes (two chunks and the smallest hash table).\n";
+			exit(1);
+		}
+		return true;
+	}
+	
+	void checkCycleWindow() {
+		if(cycleWindow < 0) {
+			std::cerr << "FATAL ERROR: BoundedSignatureFilter's cycle window can't be negative.\n";
+			exit(1);
+		}
+	}
+
+  public:
+	///Iff bounded, this filter takes a memory cap and a cycle window, and forgets old signatures to respect them
+	SignatureFilter(bool bounded = false) {
+		this->bounded = bounded;
+	}
+	
+	~SignatureFilter() {
+		for(unsigned int x = 0; x < chunks.size(); x++) {
+			delete [] chunks[x].words;
+		}
+		delete [] spareChunk;
+	}
+	
+	Filter * createEmptyCopy() {
+		SignatureFilter * f = new SignatureFilter(this->bounded);
+		f->maxBytes = this->maxBytes;
+		f->chunkShift = this->chunkShift;
+		f->chunkWords = this->chunkWords;
+		f->cycleWindow = this->cycleWindow;
+		f->numFiltered = this->numFiltered;
+		f->numReplaced = this->numReplaced;
+		f->numLookups = this->numLookups;
+		f->numEvicted = this->numEvicted;
+		f->numSecondChances = this->numSecondChances;
+		return f;
+	}
+	
+	int setArgs(char** argv) {
+		if(!bounded) {
+			return 0;
+		}
+		if(!parseMaxBytes(argv[0])) {
+			std::cerr << "FATAL ERROR: couldn't parse memory cap " << argv[0] << " for BoundedSignatureFilter.\n";
+			exit(1);
+		}
+		this->cycleWindow = atoi(argv[1]);
+		checkCycleWindow();
+		return 2;
+	}
+	
+	int setArgs() {
+		if(!bounded) {
+			return 0;
+		}
+		std::cerr << "Enter memory cap (bytes, with an optional K/M/G suffix) and then cycle window (0 for none):\n";
+		std::string str;
+		std::cin >> str;
+		std::cin >> this->cycleWindow;
+		if(!parseMaxBytes(str.c_str())) {
+			std::cerr << "FATAL ERROR: couldn't parse memory cap " << str << " for BoundedSignatureFilter.\n";
+			exit(1);
+		}
+		checkCycleWindow();
+		return 2;
+	}
+	
+	bool needsPoppedNodes() {
+		return false;
+	}
+	
+	//Expanded nodes keep their signatures, so they still filter new nodes after main frees them.
+	//We only forget nodes that won't be expanded (because a later filter or the queue got rid of them).
+	void deleteRecord(Node * n) {
+		if(n->expanded) {
+			return;
+		}
+		std::size_t hash = key(n);
+		this->table.find(hash, this->found);
+		for(unsigned int x = 0; x < this->found.size(); x++) {
+			uint64_t offset = this->table.at(this->found[x]) - 1;
+			const uint16_t * busy = sameState(signature(offset), n);
+			if(!busy) {
+				continue;
+			}
+			bool same = true;
+			for(int y = 0; y < numQubits && same; y++) {
+				same = busy[y] == n->busyCycles(y);
+			}
+			if(same) {
+				this->table.removeFound(this->found, x);
+				numSignatures--;
+				if(offset + numWords(n->readyGates.size()) == used) {
+					//it's the newest signature (as when a later filter rejects a node we just let through), so reuse its space
+					used = offset;
+					chunkOf(offset).fill = offset & (chunkWords - 1);
+				}
+				return;
+			}
+		}
+	}
+	
+	bool filter(Node * newNode) {
+		if(!numQubits) {
+			numQubits = newNode->env->numPhysicalQubits;
+			//a node has at most one ready gate per qubit, and a signature has to fit in a chunk:
+			if(numWords(numQubits) > chunkWords) {
+				std::cerr << "FATAL ERROR: SignatureFilter's chunks are too small for " << numQubits << " qubits; raise the memory cap.\n";
+				exit(1);
+			}
+		}
+		numLookups++;
+		if(bounded) {
+			if(newNode->cycle > latestCycle) {
+				latestCycle = newNode->cycle;
+			}
+			evict();
+		}
+		
+		std::size_t hash = key(newNode);
+		this->table.find(hash, this->found);
+		for(unsigned int x = this->found.size() - 1; x < this->found.size(); x--) {
+			uint64_t offset = this->table.at(this->found[x]) - 1;
+			const uint16_t * busy = sameState(signature(offset), newNode);
+			if(!busy) {
+				continue;
+			}
+			
+			bool oldIsBetter = true;
+			bool newIsBetter = true;
+			for(int y = 0; y < numQubits && (oldIsBetter || newIsBetter); y++) {
+				int newBusy = newNode->busyCycles(y);
+				if(busy[y] > newBusy) {
+					oldIsBetter = false;
+				} else if(busy[y] < newBusy) {
+					newIsBetter = false;
+				}
+			}
+			
+			if(oldIsBetter) {
+				if(bounded && (offset >> chunkShift) == firstChunk && chunks.size() > 1) {
+					//it's still useful, so move it out of the way of the next eviction
+					unsigned int size = numWords(newNode->readyGates.size());
+					uint64_t copy = allocate(size, newNode->cycle);
+					std::memcpy(signature(copy), signature(offset), size * sizeof(uint32_t));
+					this->table.set(this->found[x], copy + 1);
+					numSignatures--;
+					numSecondChances++;
+				}
+				numFiltered++;
+				return true;
+			} else if(newIsBetter) {
+				//the old node is still around (or expanded already), but new nodes only need to beat this one:
+				this->table.removeFound(this->found, x);
+				numSignatures--;
+				numReplaced++;
+			}
+		}
+		
+		this->table.insert(hash, store(newNode) + 1);
+		return false;
+	}
+	
+	virtual void printStatistics(std::ostream & stream) {
+		stream << "//SignatureFilter filtered " << numFiltered << " total nodes.\n";
+		stream << "//SignatureFilter replaced " << numReplaced << " signatures; " << numSignatures << " signatures take " << getBytes() << " bytes.\n";
+		if(bounded) {
+			stream << "//SignatureFilter hit rate: " << numFiltered << " of " << numLookups << " nodes filtered (" << (numLookups ? 100.0 * numFiltered / numLookups : 0.0) << "%).\n";
+			stream << "//SignatureFilter evicted " << numEvicted << " signatures, and gave " << numSecondChances << " signatures a second chance.\n";
+		}
+	}
+};
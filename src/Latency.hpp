@@ -1,13 +1,18 @@
 #ifndef LATENCY_HPP
 #define LATENCY_HPP
 
-#include <string>
+#include "GateType.hpp"
 using namespace std;
 
 class Latency {
   public:
 	virtual ~Latency() {};
-	virtual int getLatency(string gateName, int numQubits, int target, int control) = 0;
+	virtual int getLatency(int gateType, int numQubits, int target, int control) = 0;//gateType is an id from GateType
+	
+	virtual void compile(int numPhysicalQubits) {
+		//This is called once the circuit and coupling map are loaded, so every gate type is known;
+		//latency models can use it to precompute their answers
+	}
 	
 	virtual int setArgs(char** argv) {
 		//This is used to set the queue's parameters via command-line
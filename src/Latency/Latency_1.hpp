@@ -6,7 +6,7 @@
 //Latency example: 1 cycle for EVERY gate
 class Latency_1 : public Latency {
   public:
-	int getLatency(string gateName, int numQubits, int target, int control) {
+	int getLatency(int gateType, int numQubits, int target, int control) {
 		return 1;
 	}
 };
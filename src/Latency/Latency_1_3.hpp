@@ -3,8 +3,8 @@
 //Latency example: 3 cycles per SWP; 1 cycle otherwise
 class Latency_1_3 : public Latency {
   public:
-	int getLatency(string gateName, int numQubits, int target, int control) {
-		if(!gateName.compare("swp") || !gateName.compare("SWP")) {
+	int getLatency(int gateType, int numQubits, int target, int control) {
+		if(GateType::isSwapName(gateType)) {
 			return 3;
 		} else {
 			return 1;
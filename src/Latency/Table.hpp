@@ -6,7 +6,9 @@
 #include <fstream>
 #include <iostream>
 #include <cassert>
+#include <climits>
 #include <unordered_map>
+#include <vector>
 #include <utility>
 #include <tuple>
 using namespace std;
@@ -43,43 +45,42 @@ using namespace std;
 class Table : public Latency {
   private:
 	
-	typedef std::tuple<char *, int, int, int> key_t;
+	//gate types are GateType ids; -1 stands for any gate
+	typedef std::tuple<int, int, int, int> key_t;
 	
 	struct key_hash : public std::unary_function<key_t, std::size_t> {
 		std::size_t operator()(const key_t& k) const {
-		return std::get<0>(k)[0] ^ std::get<1>(k) ^ std::get<2>(k) ^ std::get<3>(k);
-		}
-	};
-
-	struct key_equal : public std::binary_function<key_t, key_t, bool> {
-		bool operator()(const key_t& v0, const key_t& v1) const {
-		return (!strcmp(std::get<0>(v0), std::get<0>(v1)) &&
-				std::get<1>(v0) == std::get<1>(v1) &&
-				std::get<2>(v0) == std::get<2>(v1) &&
-				std::get<3>(v0) == std::get<3>(v1) );
+		std::size_t h = (std::size_t) std::get<0>(k);
+		h = h * 31 + std::get<1>(k);
+		h = h * 31 + std::get<2>(k);
+		h = h * 31 + std::get<3>(k);
+		return h;
 		}
 	};
 	
-	typedef std::tuple<char *, int> key_t2;
+	typedef std::tuple<int, int> key_t2;
 	
 	struct key_hash2 : public std::unary_function<key_t2, std::size_t> {
 		std::size_t operator()(const key_t2& k) const {
-		return std::get<0>(k)[0] ^ std::get<1>(k);
-		}
-	};
-
-	struct key_equal2 : public std::binary_function<key_t2, key_t2, bool> {
-		bool operator()(const key_t2& v0, const key_t2& v1) const {
-		return (!strcmp(std::get<0>(v0), std::get<0>(v1)) &&
-				std::get<1>(v0) == std::get<1>(v1) );
+		return ((std::size_t) std::get<0>(k) << 8) ^ std::get<1>(k);
 		}
 	};
 	
 	//map using gate's name, # bits, physical target, and physical control as key(s).
-	std::unordered_map<key_t, int, key_hash, key_equal> latencies;
+	std::unordered_map<key_t, int, key_hash> latencies;
 	
 	//best-case latency map when we haven't yet decided on physical qubits
-	std::unordered_map<key_t2, int, key_hash2, key_equal2> optimisticLatencies;
+	std::unordered_map<key_t2, int, key_hash2> optimisticLatencies;
+	
+	//Flat lookup tables filled in by compile(), for gate types 0 through numCompiledTypes-1:
+	static const int MISSING = INT_MIN;//no latency-table entry applies
+	int numCompiledTypes = 0;
+	int numPhysicalQubits = 0;
+	vector<int> compiledOptimistic;//[type*2 + numQubits-1], for gates without physical qubits
+	vector<int> compiledOneQubit;//[type*numPhysicalQubits + target]
+	vector<int> compiledTwoQubit;//[pairOffset[type] + target*numPhysicalQubits + control]
+	vector<int> pairOffset;//-1 if the table has no per-qubit entries for this 2-qubit gate type
+	vector<int> twoQubitDefault;//latency of a 2-qubit gate type without per-qubit entries
 	
 	//Tokenizer for parsing the latency table file:
 	char * getToken(std::ifstream & infile) {
@@ -144,12 +145,13 @@ class Table : public Latency {
 		while((token = getToken(infile))) {//Reminder: the single = instead of double == here is intentional.
 			int numBits = atoi(token);
 			char * gateName = getToken(infile);
+			int gateType = strcmp(gateName, "-") ? GateType::intern(gateName) : -1;
 			char * target = getToken(infile);
 			char * control = getToken(infile);
 			char * latency = getToken(infile);;
 			
 			//Don't allow entries where physical qubits are only partially specified:
-			assert(numBits < 2 || (strcmp(target, "-") == strcmp(control, "-")));
+			assert(numBits < 2 || (!strcmp(target, "-") == !strcmp(control, "-")));
 			
 			int targetVal = -1;
 			if(strcmp(target, "-")) {
@@ -167,16 +169,16 @@ class Table : public Latency {
 			}
 			
 			//Don't allow duplicate entries
-			auto search = latencies.find(make_tuple(gateName, numBits, targetVal, controlVal));
+			auto search = latencies.find(make_tuple(gateType, numBits, targetVal, controlVal));
 			assert(search == latencies.end());
 			
-			latencies.emplace(make_tuple(gateName, numBits, targetVal, controlVal), latencyVal);
+			latencies.emplace(make_tuple(gateType, numBits, targetVal, controlVal), latencyVal);
 			
 			//record best-case latency for this gate regardless of physical qubits
-			if(strcmp(gateName, "-")) {
-				auto search = optimisticLatencies.find(make_tuple((char*) gateName, numBits));
+			if(gateType >= 0) {
+				auto search = optimisticLatencies.find(make_tuple(gateType, numBits));
 				if(search == optimisticLatencies.end()) {
-					optimisticLatencies.emplace(make_tuple((char*) gateName, numBits), latencyVal);
+					optimisticLatencies.emplace(make_tuple(gateType, numBits), latencyVal);
 				} else {
 					if(search->second > latencyVal) {
 						search->second = latencyVal;
@@ -186,38 +188,101 @@ class Table : public Latency {
 		}
 	}
   
-  public:
-	int getLatency(string gateName, int numQubits, int target, int control) {
+	//Apply the latency table's fallback rules; returns MISSING if no entry applies
+	int find(int gateType, int numQubits, int target, int control) {
 		if(numQubits > 0 && target < 0 && control < 0) {
 			//We're dealing with a logical gate, so let's return the best case among physical possibilities (so that our a* search will still work okay):
-			auto search = optimisticLatencies.find(make_tuple((char*) gateName.c_str(), numQubits));
+			auto search = optimisticLatencies.find(make_tuple(gateType, numQubits));
 			if(search != optimisticLatencies.end()) {
 				return search->second;
 			}
 		}
 		
 		//Try to find perfectly matching latency:
-		auto search = latencies.find(make_tuple((char*) gateName.c_str(), numQubits, target, control));
+		auto search = latencies.find(make_tuple(gateType, numQubits, target, control));
 		if(search != latencies.end()) {
 			return search->second;
 		}
 		
 		//Try to find matching latency without physical qubits specified
-		search = latencies.find(make_tuple((char*) gateName.c_str(), numQubits, -1, -1));
+		search = latencies.find(make_tuple(gateType, numQubits, -1, -1));
 		if(search != latencies.end()) {
 			return search->second;
 		}
 		
 		//Try to find matching latency without physical qubits or gate name specified
-		search = latencies.find(make_tuple((char*) "-", numQubits, -1, -1));
+		search = latencies.find(make_tuple(-1, numQubits, -1, -1));
 		if(search != latencies.end()) {
 			return search->second;
 		}
 		
-		//Crash
-		std::cerr << "FATAL ERROR: could not find any valid latency for specified " << gateName << " gate.\n";
-		std::cerr << "\t" << numQubits << "\t" << gateName << "\t" << target << "\t" << control << "\n";
-		exit(1);
+		return MISSING;
+	}
+  
+  public:
+	void compile(int numPhysicalQubits) {
+		int n = numPhysicalQubits;
+		this->numPhysicalQubits = n;
+		this->numCompiledTypes = GateType::count();
+		
+		compiledOptimistic.resize(numCompiledTypes * 2);
+		compiledOneQubit.resize(numCompiledTypes * n);
+		pairOffset.assign(numCompiledTypes, -1);
+		twoQubitDefault.resize(numCompiledTypes);
+		compiledTwoQubit.clear();
+		
+		//only gate types with per-qubit entries need a full table of physical qubit pairs:
+		for(auto iter = latencies.begin(); iter != latencies.end(); iter++) {
+			int gateType = std::get<0>(iter->first);
+			if(gateType >= 0 && std::get<1>(iter->first) == 2 && std::get<2>(iter->first) >= 0 && pairOffset[gateType] < 0) {
+				pairOffset[gateType] = 0;
+			}
+		}
+		
+		for(int t = 0; t < numCompiledTypes; t++) {
+			compiledOptimistic[t * 2] = find(t, 1, -1, -1);
+			compiledOptimistic[t * 2 + 1] = find(t, 2, -1, -1);
+			for(int x = 0; x < n; x++) {
+				compiledOneQubit[t * n + x] = find(t, 1, x, -1);
+			}
+			
+			twoQubitDefault[t] = find(t, 2, n, n);//no entry names physical qubit n, so this skips straight to the defaults
+			if(pairOffset[t] >= 0) {
+				pairOffset[t] = compiledTwoQubit.size();
+				for(int x = 0; x < n; x++) {
+					for(int y = 0; y < n; y++) {
+						compiledTwoQubit.push_back(find(t, 2, x, y));
+					}
+				}
+			}
+		}
+	}
+	
+	int getLatency(int gateType, int numQubits, int target, int control) {
+		int latency;
+		if(gateType < 0 || gateType >= numCompiledTypes || numQubits < 1 || numQubits > 2) {
+			latency = find(gateType, numQubits, target, control);
+		} else if(target < 0 && control < 0) {
+			latency = compiledOptimistic[gateType * 2 + numQubits - 1];
+		} else if(numQubits == 1 && control < 0) {
+			latency = compiledOneQubit[gateType * numPhysicalQubits + target];
+		} else if(numQubits == 2 && target >= 0 && control >= 0) {
+			int offset = pairOffset[gateType];
+			if(offset < 0) {
+				latency = twoQubitDefault[gateType];
+			} else {
+				latency = compiledTwoQubit[offset + target * numPhysicalQubits + control];
+			}
+		} else {
+			latency = find(gateType, numQubits, target, control);
+		}
+		
+		if(latency == MISSING) {
+			std::cerr << "FATAL ERROR: could not find any valid latency for specified " << GateType::name(gateType) << " gate.\n";
+			std::cerr << "\t" << numQubits << "\t" << GateType::name(gateType) << "\t" << target << "\t" << control << "\n";
+			exit(1);
+		}
+		return latency;
 	}
 	
 	int setArgs(char** argv) {
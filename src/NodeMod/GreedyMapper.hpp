@@ -54,7 +54,7 @@ class GreedyMapper : public NodeMod {
 						if(node->qal[x] < 0) {
 							for(int y = x + 1; y < env->numPhysicalQubits; y++) {
 								if(node->qal[y] < 0) {
-									int dist = env->couplingDistances[x * env->numPhysicalQubits + y];
+									int dist = env->device->distance(x, y);
 									if(dist < bestDistance) {
 										bestTarget = x;
 										bestControl = y;
@@ -81,7 +81,7 @@ class GreedyMapper : public NodeMod {
 					for(int x = 0; x < env->numPhysicalQubits; x++) {
 						if(x != physT) {
 							if(node->qal[x] < 0) {
-								int dist = env->couplingDistances[x * env->numPhysicalQubits + physT];
+								int dist = env->device->distance(x, physT);
 								if(dist < bestDistance) {
 									bestBit = x;
 									bestDistance = dist;
@@ -99,7 +99,7 @@ class GreedyMapper : public NodeMod {
 					for(int x = 0; x < env->numPhysicalQubits; x++) {
 						if(x != physC) {
 							if(node->qal[x] < 0) {
-								int dist = env->couplingDistances[x * env->numPhysicalQubits + physC];
+								int dist = env->device->distance(x, physC);
 								if(dist < bestDistance) {
 									bestBit = x;
 									bestDistance = dist;
@@ -21,6 +21,9 @@ class Queue {
   public:
 	virtual ~Queue() {};
 	
+	///Create a new, empty queue with the same parameters as this one
+	virtual Queue * createEmptyCopy() = 0;
+	
 	virtual int setArgs(char** argv) {
 		//This is used to set the queue's parameters via command-line
 		//return number of args consumed
@@ -41,10 +44,29 @@ class Queue {
 	///Return number of elements in queue
 	virtual int size() = 0;
 	
+	///Return true iff this queue can't go on searching within its memory limits;
+	///main then stops as though it hit a limit, finishing the most promising node greedily
+	virtual bool isOutOfMemory() {
+		return false;
+	}
+	
+	///Return true iff the cost of each node this queue pops is a lower bound on every schedule we haven't found yet,
+	///including schedules through nodes the queue dropped (e.g. because it keeps their cost in a surviving ancestor);
+	///a queue that pops the cheapest node it holds but drops nodes without accounting for them (like TrimSlowNodes) must return false
+	virtual bool popsCheapestFirst() {
+		return false;
+	}
+	
+	///Return true iff this queue may push a node again after it has been popped
+	///(so the search must keep every expanded node alive, and not delete it twice)
+	virtual bool reexpandsNodes() {
+		return false;
+	}
+	
 	///Push a node into the priority queue
 	///Return false iff this fails for any reason
 	///Pre-condition: newNode->cost has already been set
-	bool push(Node * newNode) {
+	virtual bool push(Node * newNode) {
 		numPushed++;
 		if(!newNode->env->filter(newNode)) {
 			bool success = this->pushNode(newNode);
@@ -0,0 +1,239 @@
+#include "Queue.hpp"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <iostream>
+
+extern bool _verbose;
+
+/**
+ * This queue runs a beam search: it groups nodes into levels, keeps only the best W nodes of each level,
+	and finishes popping one level before moving on to the next.
+ * It takes 2 params: the beam width W, and what a level is:
+	cycle (nodes at the same cycle),
+	or gates (nodes with the same number of unscheduled gates, and the same number of cycles since they last scheduled one).
+	In gates mode, we stop swapping at a number of unscheduled gates once the next one has W nodes waiting,
+	and drop nodes that go swapCost * (number of physical qubits) cycles without scheduling a gate.
+ * A level never yields more than W nodes, so a search pops at most W nodes per level.
+	Unless a filter needs popped nodes (HashFilter and HashFilter2 do) or -retainPopped is set,
+	main frees each node once it's expanded, so the search keeps O(W * depth) nodes in memory.
+ * This gives up on optimality: the search ends with the first final node it pops.
+	Use it with a filter; otherwise copies of the same state crowd the beam.
+	In gates mode, SignatureFilter does that and keeps the memory bound.
+	In cycle mode, use HashFilter and HashFilter2, since SignatureFilter only compares nodes at the same cycle,
+	and a narrow beam can end up swapping the same qubits back and forth forever.
+ */
+class BeamQueue : public Queue {
+  private:
+	enum LevelType {CYCLE, GATES};
+	LevelType levelType = CYCLE;
+	int width = 1000;
+	
+	//A level is a pair: the cycle, or minus the number of unscheduled gates,
+	//and then (for gates) the number of cycles since the node last scheduled a gate from the circuit.
+	//Without that second part, children that only swap qubits would land in the level we're popping,
+	//which runs out of room after W pops, so a beam that needs a few swaps in a row could never make progress.
+	typedef std::pair<int, int> Level;
+	
+	//lower cost is better, with fewer unscheduled gates as tiebreaker
+	struct CmpBetter {
+		bool operator()(const Node* lhs, const Node* rhs) const {
+			if(lhs->cost == rhs->cost) {
+				return lhs->numUnscheduledGates < rhs->numUnscheduledGates;
+			}
+			return lhs->cost < rhs->cost;
+		}
+	};
+	
+	//Each level's nodes are a heap with the worst node on top until we start popping that level;
+	//after that, they're sorted from worst to best.
+	std::map<Level, std::vector<Node*> > levels;
+	Level currentLevel = Level(INT_MIN, INT_MIN);//the level we're popping from
+	int numTakenFromLevel = 0;//number of nodes popped from the current level so far
+	int numNodes = 0;
+	int numDropped = 0;
+	
+	//most cycles a node in gates mode can go without scheduling a gate from the circuit before we drop it
+	inline int maxStall(Node * n) {
+		return n->env->swapCost * n->env->numPhysicalQubits;
+	}
+	
+	//number of cycles since n last started a gate from the circuit (or since the search started, if it hasn't)
+	inline int stallOf(Node * n) {
+		int lastProgress = -1;
+		for(int x = 0; x < n->env->numLogicalQubits; x++) {
+			ScheduledGate * sg = n->lastNonSwapGate[x];
+			if(sg && sg->cycle > lastProgress) {
+				lastProgress = sg->cycle;
+			}
+		}
+		return n->cycle - lastProgress;
+	}
+	
+	inline Level levelOf(Node * n) {
+		Level level = (levelType == CYCLE) ? Level(n->cycle, 0) : Level(-n->numUnscheduledGates, stallOf(n));
+		//a node can't go back to a level we're done with:
+		return std::max(level, currentLevel);
+	}
+	
+	inline void drop(Node * n) {
+		n->env->deleteRecord(n);
+		delete n;
+		numDropped++;
+	}
+	
+	//whether we should skip the specified level (which we haven't started on),
+	//since it only holds nodes that swapped more than the current level's, and the next gate count already has a full beam
+	bool isPointlessStall(const Level & level) {
+		if(levelType != GATES || level.first != currentLevel.first || level == currentLevel) {
+			return false;
+		}
+		auto next = levels.lower_bound(Level(level.first + 1, INT_MIN));
+		return next != levels.end() && (int) next->second.size() >= width;
+	}
+	
+	bool pushNode(Node * newNode) {
+		Level level = levelOf(newNode);
+		if(levelType == GATES && level.second > maxStall(newNode)) {
+			//it's been swapping too long to be going anywhere
+			drop(newNode);
+			return true;
+		}
+		std::vector<Node*> & nodes = levels[level];
+		bool isCurrent = (level == currentLevel);
+		int room = isCurrent ? width - numTakenFromLevel : width;
+		
+		if((int) nodes.size() >= room) {
+			//the level is full, so newNode has to beat its worst node to get in
+			if(nodes.empty() || !CmpBetter()(newNode, nodes.front())) {
+				drop(newNode);
+				return true;
+			}
+			if(isCurrent) {
+				drop(nodes.front());
+				nodes.erase(nodes.begin());
+			} else {
+				std::pop_heap(nodes.begin(), nodes.end(), CmpBetter());
+				drop(nodes.back());
+				nodes.pop_back();
+			}
+			numNodes--;
+		}
+		
+		if(isCurrent) {
+			//keep sorted from worst to best
+			auto pos = std::upper_bound(nodes.begin(), nodes.end(), newNode, [](const Node* lhs, const Node* rhs) {
+				return CmpBetter()(rhs, lhs);
+			});
+			nodes.insert(pos, newNode);
+		} else {
+			nodes.push_back(newNode);
+			std::push_heap(nodes.begin(), nodes.end(), CmpBetter());
+		}
+		numNodes++;
+		return true;
+	}
+	
+	bool parseLevelType(std::string str) {
+		for(unsigned int x = 0; x < str.size(); x++) {
+			str[x] = std::tolower(str[x]);
+		}
+		if(str == "cycle") {
+			levelType = CYCLE;
+		} else if(str == "gates") {
+			levelType = GATES;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+  public:
+	Queue * createEmptyCopy() {
+		BeamQueue * q = new BeamQueue();
+		q->levelType = this->levelType;
+		q->width = this->width;
+		return q;
+	}
+	
+	int setArgs(char** argv) {
+		this->width = atoi(argv[0]);
+		if(this->width < 1) {
+			std::cerr << "FATAL ERROR: beam width must be at least 1.\n";
+			exit(1);
+		}
+		if(!parseLevelType(argv[1])) {
+			std::cerr << "FATAL ERROR: unrecognized level type " << argv[1] << " for BeamQueue.\n";
+			exit(1);
+		}
+		return 2;
+	}
+	
+	int setArgs() {
+		std::cerr << "Enter beam width and then level type (cycle or gates):\n";
+		std::string str;
+		std::cin >> this->width;
+		std::cin >> str;
+		if(this->width < 1) {
+			std::cerr << "FATAL ERROR: beam width must be at least 1.\n";
+			exit(1);
+		}
+		if(!parseLevelType(str)) {
+			std::cerr << "FATAL ERROR: unrecognized level type " << str << " for BeamQueue.\n";
+			exit(1);
+		}
+		return 2;
+	}
+	
+	Node * pop() {
+		numPopped++;
+		
+		//skip past levels we've emptied, and past more swapping once there's a full beam of nodes with more progress:
+		while(levels.begin()->second.empty() || isPointlessStall(levels.begin()->first)) {
+			std::vector<Node*> & nodes = levels.begin()->second;
+			for(Node * n : nodes) {
+				drop(n);
+			}
+			numNodes -= nodes.size();
+			levels.erase(levels.begin());
+		}
+		
+		std::vector<Node*> & nodes = levels.begin()->second;
+		if(levels.begin()->first != currentLevel) {
+			//start on the next level
+			currentLevel = levels.begin()->first;
+			numTakenFromLevel = 0;
+			std::sort_heap(nodes.begin(), nodes.end(), CmpBetter());
+			std::reverse(nodes.begin(), nodes.end());
+			if(_verbose) {
+				std::cerr << "dbg msg: beam moved to level " << currentLevel.first << "," << currentLevel.second << " with " << nodes.size() << " nodes; " << numDropped << " nodes dropped so far.\n";
+			}
+		}
+		
+		Node * ret = nodes.back();
+		nodes.pop_back();
+		numTakenFromLevel++;
+		numNodes--;
+		
+		if(!ret->readyGates.size()) {
+			assert(ret->numUnscheduledGates == 0);
+			if(!bestFinalNode) {
+				if(_verbose) std::cerr << "dbg msg: found a final node.\n";
+				bestFinalNode = ret;
+			} else if(ret->cost < bestFinalNode->cost) {
+				if(_verbose)  std::cerr << "dbg msg: found a better final node.\n";
+				bestFinalNode = ret;
+			}
+		}
+		
+		return ret;
+	}
+	
+	int size() {
+		return numNodes;
+	}
+};
@@ -0,0 +1,155 @@
+#include "Queue.hpp"
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <iostream>
+
+extern bool _verbose;
+
+/**
+ * This queue keeps one bucket of nodes per cost value, so push and pop are O(1) amortized.
+ * It relies on costs being small integers that mostly increase as the search goes on;
+ * a node cheaper than every bucket so far just makes the bucket array grow at the front.
+ * It takes one param, the tiebreaker among nodes of equal cost:
+	LIFO (most recently pushed node first),
+	deepest (fewest unscheduled gates first),
+	or cost2 (lowest cost2 first).
+ * The last two keep each bucket as a binary heap, so they cost O(log bucket size) instead.
+ */
+class BucketQueue : public Queue {
+  private:
+	enum TieBreak {LIFO, DEEPEST, COST2};
+	TieBreak tieBreak = LIFO;
+	
+	struct CmpDeepest {
+		bool operator()(const Node* lhs, const Node* rhs) const {
+			return lhs->numUnscheduledGates > rhs->numUnscheduledGates;
+		}
+	};
+	
+	struct CmpCost2 {
+		bool operator()(const Node* lhs, const Node* rhs) const {
+			return lhs->cost2 > rhs->cost2;
+		}
+	};
+	
+	std::vector<std::vector<Node*> > buckets;//buckets[x] holds the nodes with cost baseCost+x
+	int baseCost = 0;
+	unsigned int current = 0;//no bucket before this one has any nodes
+	int numNodes = 0;
+	
+	bool pushNode(Node * newNode) {
+		if(buckets.empty()) {
+			baseCost = newNode->cost;
+			current = 0;
+		} else if(newNode->cost < baseCost) {
+			//make room at the front for the cheaper node:
+			int shift = baseCost - newNode->cost;
+			buckets.insert(buckets.begin(), shift, std::vector<Node*>());
+			baseCost = newNode->cost;
+			current += shift;
+		}
+		
+		unsigned int index = newNode->cost - baseCost;
+		if(index >= buckets.size()) {
+			buckets.resize(index + 1);
+		}
+		std::vector<Node*> & bucket = buckets[index];
+		bucket.push_back(newNode);
+		if(tieBreak == DEEPEST) {
+			std::push_heap(bucket.begin(), bucket.end(), CmpDeepest());
+		} else if(tieBreak == COST2) {
+			std::push_heap(bucket.begin(), bucket.end(), CmpCost2());
+		}
+		
+		if(index < current) {
+			current = index;
+		}
+		numNodes++;
+		return true;
+	}
+	
+	bool parseTieBreak(std::string str) {
+		for(unsigned int x = 0; x < str.size(); x++) {
+			str[x] = std::tolower(str[x]);
+		}
+		if(str == "lifo") {
+			tieBreak = LIFO;
+		} else if(str == "deepest") {
+			tieBreak = DEEPEST;
+		} else if(str == "cost2") {
+			tieBreak = COST2;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+  public:
+	Queue * createEmptyCopy() {
+		BucketQueue * q = new BucketQueue();
+		q->tieBreak = this->tieBreak;
+		return q;
+	}
+	
+	int setArgs(char** argv) {
+		if(!parseTieBreak(argv[0])) {
+			std::cerr << "FATAL ERROR: unrecognized tiebreaker " << argv[0] << " for BucketQueue.\n";
+			exit(1);
+		}
+		return 1;
+	}
+	
+	int setArgs() {
+		std::cerr << "Enter tiebreaker for nodes of equal cost (LIFO, deepest, or cost2):\n";
+		std::string str;
+		std::cin >> str;
+		if(!parseTieBreak(str)) {
+			std::cerr << "FATAL ERROR: unrecognized tiebreaker " << str << " for BucketQueue.\n";
+			exit(1);
+		}
+		return 1;
+	}
+	
+	Node * pop() {
+		numPopped++;
+		
+		while(buckets[current].empty()) {
+			//release the memory of buckets we're done with
+			std::vector<Node*>().swap(buckets[current]);
+			current++;
+		}
+		
+		std::vector<Node*> & bucket = buckets[current];
+		if(tieBreak == DEEPEST) {
+			std::pop_heap(bucket.begin(), bucket.end(), CmpDeepest());
+		} else if(tieBreak == COST2) {
+			std::pop_heap(bucket.begin(), bucket.end(), CmpCost2());
+		}
+		Node * ret = bucket.back();
+		bucket.pop_back();
+		numNodes--;
+		
+		if(!ret->readyGates.size()) {
+			assert(ret->numUnscheduledGates == 0);
+			if(!bestFinalNode) {
+				if(_verbose) std::cerr << "dbg msg: found a final node.\n";
+				bestFinalNode = ret;
+			} else if(ret->cost < bestFinalNode->cost) {
+				if(_verbose)  std::cerr << "dbg msg: found a better final node.\n";
+				bestFinalNode = ret;
+			}
+		}
+		
+		return ret;
+	}
+	
+	int size() {
+		return numNodes;
+	}
+	
+	bool popsCheapestFirst() {
+		return true;
+	}
+};
@@ -56,6 +56,10 @@ class DefaultQueue : public Queue {
 	int garbage2 = 9999999;
 	
   public:
+	Queue * createEmptyCopy() {
+		return new DefaultQueue();
+	}
+	
 	Node * pop() {
 		numPopped++;
 		
@@ -83,4 +87,8 @@ class DefaultQueue : public Queue {
 	int size() {
 		return nodes.size();
 	}
+	
+	bool popsCheapestFirst() {
+		return true;
+	}
 };
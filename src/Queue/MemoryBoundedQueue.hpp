@@ -0,0 +1,462 @@
+#include "Queue.hpp"
+#include "ScheduleLog.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <iostream>
+
+extern bool _verbose;
+
+/**
+ * An SMA*-style queue that keeps the search within a memory budget.
+ * It takes one param: the budget, either a number of nodes or a number of bytes with a K, M, or G suffix (e.g. 4G).
+	The budget covers every node in memory: the ones in this queue plus the expanded ones their schedules build on.
+	A byte budget also covers the schedule log entries those nodes use (see ScheduleLog).
+ * Whenever a push puts the search over budget, the queue forgets its most expensive leaf
+	(a node with no children in memory), and backs that node's cost up into its parent, which goes back into the queue.
+	Popping the parent again re-expands it; of the children that generates, only the forgotten ones are pushed
+	(at the cost they had when we forgot them), since the others are still in memory.
+	Expanded nodes with no children left in memory are deleted as well.
+ * A child never costs less than its parent (pathmax), so the costs we pop never go down, and each one is a lower bound.
+	Otherwise, as costs bounced back down, the same nodes would be forgotten and regenerated over and over.
+ * As long as the budget is never reached, this is an A* queue (one bucket per cost, LIFO within a bucket).
+	Otherwise it trades time for memory, and still finds the best solution if it fits in the budget.
+	If the budget can't even hold the nodes at the current cost (we've forgotten more of them than the budget holds),
+	the queue reports that it's out of memory, and main finishes the cheapest node greedily, reporting its cost as a lower bound.
+ * Since it pushes expanded nodes again, this queue (not main) owns every node it has popped:
+	it can't be combined with -retainPopped or with -threads.
+ */
+class MemoryBoundedQueue : public Queue {
+  private:
+	long long budget = 1000000;
+	bool budgetInBytes = false;
+	long long maxNodes = 0;//set on first push, once the node size is known
+	std::size_t nodeBytes = 0;//bytes we count for each node against a byte budget
+	ScheduleLog * log = 0;
+	
+	struct Bucket {
+		std::deque<Node*> leaves;//nodes with no children in memory, which we can forget
+		std::deque<Node*> parents;//requeued nodes whose children we have to forget first
+		
+		inline bool empty() const {
+			return leaves.empty() && parents.empty();
+		}
+		
+		inline std::deque<Node*> & listOf(Node * n) {
+			return n->numChildren ? parents : leaves;
+		}
+	};
+	
+	std::vector<Bucket> buckets;//buckets[x] holds the nodes with cost baseCost+x
+	int baseCost = 0;
+	unsigned int low = 0;//no bucket before this one has any nodes
+	unsigned int high = 0;//no bucket after this one has any nodes
+	int numQueued = 0;
+	
+	std::unordered_set<Node*> retained;//popped nodes that are still in memory (including requeued ones)
+	long long numNodes = 0;//nodes in memory: the ones in the queue plus the retained ones
+	long long numForgotten = 0;
+	
+	int bound = INT_MIN;//cost of the last node we popped, a lower bound on the cost of any solution
+	long long numForgottenAtBound = 0;//nodes we've forgotten at a cost no higher than bound, since it last went up
+	bool outOfMemory = false;
+	
+	Node * lastPopped = 0;//the node being expanded, which mustn't be deleted yet
+	std::vector<Node*> pendingParents;//parents with forgotten children, to requeue once the current expansion finishes
+	
+	//a child a node has forgotten: its fingerprint, and the cost it had (backed up from its own forgotten children)
+	struct Forgotten {
+		uint64_t fingerprint;
+		int cost;
+	};
+	
+	//the children each node has forgotten since it was last queued
+	std::unordered_map<Node*, std::vector<Forgotten> > forgottenChildren;
+	Node * reexpanding = 0;//the node being expanded, if it was requeued
+	std::vector<Forgotten> toRegenerate;//reexpanding's forgotten children that it hasn't pushed yet
+	long long numDuplicates = 0;//children of re-expanded nodes we dropped, since they were still in memory
+	
+	//Tells a node apart from its siblings: its qubit mapping, ready gates, cycle, and how long each qubit stays busy
+	static uint64_t fingerprint(Node * n) {
+		uint64_t hash = n->stateHash() ^ Node::mix64((uint64_t) (uint32_t) n->cycle << 40);
+		for(int x = 0; x < n->env->numPhysicalQubits; x++) {
+			int busy = n->busyCycles(x);
+			if(busy) {
+				hash ^= Node::mix64((1ULL << 62) | ((uint64_t) x << 32) | (uint32_t) busy);
+			}
+		}
+		return hash;
+	}
+	
+	void insert(Node * n) {
+		if(buckets.empty()) {
+			baseCost = n->cost;
+			low = high = 0;
+		} else if(n->cost < baseCost) {
+			//make room at the front for the cheaper node:
+			int shift = baseCost - n->cost;
+			buckets.insert(buckets.begin(), shift, Bucket());
+			baseCost = n->cost;
+			low += shift;
+			high += shift;
+		}
+		
+		unsigned int index = n->cost - baseCost;
+		if(index >= buckets.size()) {
+			buckets.resize(index + 1);
+		}
+		if(n->requeued) {
+			//among equals, requeued nodes are the shallowest: pop them last and forget them first,
+			//or two of them can take turns regenerating a child and forgetting the other's
+			buckets[index].listOf(n).push_front(n);
+		} else {
+			buckets[index].listOf(n).push_back(n);
+		}
+		if(numQueued == 0 || index < low) {
+			low = index;
+		}
+		if(numQueued == 0 || index > high) {
+			high = index;
+		}
+		numQueued++;
+	}
+	
+	//Remove and return the cheapest node (most recently pushed among equals, leaves first)
+	Node * removeBest() {
+		while(buckets[low].empty()) {
+			//release the memory of buckets we're done with
+			std::deque<Node*>().swap(buckets[low].leaves);
+			std::deque<Node*>().swap(buckets[low].parents);
+			low++;
+		}
+		std::deque<Node*> & list = buckets[low].leaves.empty() ? buckets[low].parents : buckets[low].leaves;
+		Node * n = list.back();
+		list.pop_back();
+		numQueued--;
+		return n;
+	}
+	
+	//Remove and return the most expensive leaf (least recently pushed among equals, so we don't just undo the last expansion)
+	//Returns null if every queued node has children in memory
+	Node * removeWorstLeaf() {
+		while(buckets[high].empty()) {
+			high--;
+		}
+		for(unsigned int x = high; x + 1 > low; x--) {
+			if(!buckets[x].leaves.empty()) {
+				Node * n = buckets[x].leaves.front();
+				buckets[x].leaves.pop_front();
+				numQueued--;
+				return n;
+			}
+		}
+		return 0;
+	}
+	
+	//Take one of n's children off the count; n has nothing left to forget first once it has none
+	inline void dropChild(Node * n) {
+		n->numChildren--;
+		if(!n->numChildren && n->requeued && !n->expanded) {
+			std::deque<Node*> & parents = buckets[n->cost - baseCost].parents;
+			parents.erase(std::find(parents.begin(), parents.end(), n));
+			buckets[n->cost - baseCost].leaves.push_back(n);
+		}
+	}
+	
+	//Returns true iff n is an expanded node that nothing in memory builds on anymore
+	inline bool isDeadEnd(Node * n) {
+		return n->expanded && !n->numChildren && n->forgottenCost == INT_MAX && n != bestFinalNode && n != lastPopped;
+	}
+	
+	//Delete n, along with any ancestors left as dead ends
+	void release(Node * n) {
+		while(true) {
+			Node * parent = n->parent;
+			retained.erase(n);
+			if(!forgottenChildren.empty()) {
+				forgottenChildren.erase(n);
+			}
+			numNodes--;
+			n->env->deleteRecord(n);
+			delete n;
+			
+			if(!parent) {
+				return;
+			}
+			dropChild(parent);
+			if(!isDeadEnd(parent)) {
+				return;
+			}
+			n = parent;
+		}
+	}
+	
+	//Drop the most expensive leaf in the queue, backing its cost up into its parent
+	//Returns false if every queued node has children in memory (so none can go yet)
+	bool forgetWorst() {
+		Node * n = removeWorstLeaf();
+		if(!n) {
+			return false;
+		}
+		numForgotten++;
+		if(n->cost <= bound && ++numForgottenAtBound > maxNodes) {
+			//we can't hold the nodes at the current cost all at once, so we'd regenerate them forever
+			outOfMemory = true;
+		}
+		
+		//regenerating n regenerates all of its children, so its own forgotten children count too:
+		int cost = std::min(n->cost, n->forgottenCost);
+		if(n->forgottenCost != INT_MAX) {
+			pendingParents.erase(std::find(pendingParents.begin(), pendingParents.end(), n));
+			n->forgottenCost = INT_MAX;
+		}
+		
+		Node * parent = n->parent;
+		if(parent && !n->dead && !parent->dead) {
+			if(parent->forgottenCost == INT_MAX) {
+				pendingParents.push_back(parent);
+			}
+			if(cost < parent->forgottenCost) {
+				parent->forgottenCost = cost;
+			}
+			forgottenChildren[parent].push_back(Forgotten{fingerprint(n), cost});
+		}
+		
+		release(n);
+		return true;
+	}
+	
+	//Push parents of forgotten nodes back into the queue, at the lowest cost among their forgotten children
+	void requeueParents() {
+		for(unsigned int x = 0; x < pendingParents.size(); x++) {
+			Node * parent = pendingParents[x];
+			int cost = parent->forgottenCost;
+			parent->forgottenCost = INT_MAX;
+			if(parent->dead) {
+				if(isDeadEnd(parent)) {
+					release(parent);
+				}
+			} else if(parent->expanded) {
+				parent->expanded = false;
+				parent->requeued = true;
+				parent->cost = std::max(parent->cost, cost);
+				insert(parent);
+			} else if(cost < parent->cost) {
+				//it's already queued, but one of the children it kept in memory has been forgotten since, at a lower cost
+				std::deque<Node*> & list = buckets[parent->cost - baseCost].listOf(parent);
+				list.erase(std::find(list.begin(), list.end(), parent));
+				numQueued--;
+				parent->cost = cost;
+				insert(parent);
+			}
+		}
+		pendingParents.clear();
+	}
+	
+	bool pushNode(Node * newNode) {
+		if(reexpanding && newNode->parent == reexpanding) {
+			//only the forgotten children come back; the others are still in memory
+			uint64_t print = fingerprint(newNode);
+			std::vector<Forgotten>::iterator match = toRegenerate.begin();
+			while(match != toRegenerate.end() && match->fingerprint != print) {
+				match++;
+			}
+			if(match == toRegenerate.end()) {
+				numDuplicates++;
+				newNode->env->deleteRecord(newNode);
+				delete newNode;
+				return true;
+			}
+			//it comes back with the cost we learned before forgetting it, not its first estimate:
+			newNode->cost = std::max(newNode->cost, match->cost);
+			*match = toRegenerate.back();
+			toRegenerate.pop_back();
+		}
+		if(newNode->parent) {
+			//a child can't cost less than its parent (pathmax), so the popped costs never go down:
+			newNode->cost = std::max(newNode->cost, newNode->parent->cost);
+		}
+		
+		if(!maxNodes) {
+			log = newNode->env->schedule;
+			if(budgetInBytes) {
+				//count the node, its per-qubit storage, and roughly what our containers spend on it
+				nodeBytes = sizeof(Node) + Node::storageSize + 4 * sizeof(Node*);
+				maxNodes = budget / nodeBytes;
+			} else {
+				maxNodes = budget;
+			}
+			if(maxNodes < 2) {
+				maxNodes = 2;
+			}
+		}
+		
+		insert(newNode);
+		numNodes++;
+		if(newNode->parent) {
+			newNode->parent->numChildren++;
+		}
+		
+		while(isOverBudget() && numQueued > 1) {
+			if(!forgetWorst()) {
+				break;
+			}
+		}
+		
+		return true;
+	}
+	
+	inline bool isOverBudget() {
+		if(numNodes > maxNodes) {
+			return true;
+		}
+		//a byte budget also has to cover the schedule log entries the nodes use:
+		return budgetInBytes && (long long) (numNodes * nodeBytes + log->getNumLive() * sizeof(ScheduledGate)) > budget;
+	}
+	
+	bool parseBudget(const char * str) {
+		char * end;
+		budget = std::strtoll(str, &end, 10);
+		budgetInBytes = true;
+		if(*end == 'k' || *end == 'K') {
+			budget <<= 10;
+			end++;
+		} else if(*end == 'm' || *end == 'M') {
+			budget <<= 20;
+			end++;
+		} else if(*end == 'g' || *end == 'G') {
+			budget <<= 30;
+			end++;
+		} else {
+			budgetInBytes = false;
+		}
+		return end != str && *end == 0 && budget > 0;
+	}
+
+  public:
+	~MemoryBoundedQueue() {
+		for(unsigned int x = 0; x < buckets.size(); x++) {
+			for(Node * n : buckets[x].leaves) {
+				if(!n->requeued) {
+					delete n;
+				}
+			}
+		}
+		for(Node * n : retained) {
+			delete n;
+		}
+	}
+	
+	Queue * createEmptyCopy() {
+		MemoryBoundedQueue * q = new MemoryBoundedQueue();
+		q->budget = this->budget;
+		q->budgetInBytes = this->budgetInBytes;
+		return q;
+	}
+	
+	bool reexpandsNodes() {
+		return true;
+	}
+	
+	int setArgs(char** argv) {
+		if(!parseBudget(argv[0])) {
+			std::cerr << "FATAL ERROR: couldn't parse memory budget " << argv[0] << " for MemoryBoundedQueue.\n";
+			exit(1);
+		}
+		return 1;
+	}
+	
+	int setArgs() {
+		std::cerr << "Enter memory budget (number of nodes, or bytes with a K/M/G suffix):\n";
+		std::string str;
+		std::cin >> str;
+		if(!parseBudget(str.c_str())) {
+			std::cerr << "FATAL ERROR: couldn't parse memory budget " << str << " for MemoryBoundedQueue.\n";
+			exit(1);
+		}
+		return 1;
+	}
+	
+	Node * pop() {
+		numPopped++;
+		
+		//the previous expansion is done, so we can touch its node again:
+		reexpanding = 0;
+		toRegenerate.clear();
+		requeueParents();
+		if(lastPopped) {
+			Node * n = lastPopped;
+			lastPopped = 0;
+			if(isDeadEnd(n)) {
+				release(n);
+			}
+		}
+		
+		Node * ret = removeBest();
+		ret->expanded = true;
+		if(ret->cost > bound) {
+			bound = ret->cost;
+			numForgottenAtBound = 0;
+		}
+		
+		if(ret->requeued) {
+			//already retained; if a filter has killed it since, main will skip it and we'll delete it after the next pop
+			lastPopped = ret;
+			reexpanding = ret;
+			std::unordered_map<Node*, std::vector<Forgotten> >::iterator forgotten = forgottenChildren.find(ret);
+			if(forgotten != forgottenChildren.end()) {
+				toRegenerate.swap(forgotten->second);
+				forgottenChildren.erase(forgotten);
+			}
+		} else if(!ret->dead) {
+			retained.insert(ret);
+			lastPopped = ret;
+		} else {
+			//main deletes dead nodes right away
+			numNodes--;
+			if(ret->parent) {
+				dropChild(ret->parent);
+				if(isDeadEnd(ret->parent)) {
+					release(ret->parent);
+				}
+			}
+			return ret;
+		}
+		
+		if(!ret->readyGates.size()) {
+			assert(ret->numUnscheduledGates == 0);
+			if(!bestFinalNode) {
+				if(_verbose) std::cerr << "dbg msg: found a final node.\n";
+				bestFinalNode = ret;
+			} else if(ret->cost < bestFinalNode->cost) {
+				if(_verbose)  std::cerr << "dbg msg: found a better final node.\n";
+				bestFinalNode = ret;
+			}
+		}
+		
+		if(_verbose && numForgotten) {
+			std::cerr << "dbg msg: " << numForgotten << " nodes forgotten so far; " << numDuplicates << " regenerated children dropped as still in memory.\n";
+		}
+		
+		return ret;
+	}
+	
+	int size() {
+		return numQueued;
+	}
+	
+	//forgotten nodes' costs are backed up into their queued parents, so popped costs still bound every unfound schedule:
+	bool popsCheapestFirst() {
+		return true;
+	}
+	
+	bool isOutOfMemory() {
+		return outOfMemory;
+	}
+};
@@ -5,11 +5,14 @@
 #include "Queue.hpp"
 #include "DefaultQueue.hpp"
 #include "TrimSlowNodes.hpp"
+#include "BucketQueue.hpp"
+#include "MemoryBoundedQueue.hpp"
+#include "BeamQueue.hpp"
 #include <string>
 #include <tuple>
 using namespace std;
 
-const int NUMQUEUES = 2;
+const int NUMQUEUES = 5;
 tuple<Queue*, string, string> queues[NUMQUEUES] = {
 	make_tuple(new DefaultQueue(),
 				"DefaultQueue",
@@ -17,6 +20,15 @@ tuple<Queue*, string, string> queues[NUMQUEUES] = {
 	make_tuple(new TrimSlowNodes(),
 				"TrimSlowNodes",
 				"Takes 2 params; when reaching max # nodes it removes slowest until it reaches target # nodes."),
+	make_tuple(new BucketQueue(),
+				"BucketQueue",
+				"Takes 1 param (LIFO, deepest, or cost2: how to break ties); keeps one bucket per cost value."),
+	make_tuple(new MemoryBoundedQueue(),
+				"MemoryBoundedQueue",
+				"Takes 1 param (max # nodes, or bytes with K/M/G suffix); forgets its worst nodes to stay under it (SMA*)."),
+	make_tuple(new BeamQueue(),
+				"BeamQueue",
+				"Takes 2 params (beam width, then cycle or gates: what a level is); beam search keeping the best nodes per level."),
 };
 
 #endif
\ No newline at end of file
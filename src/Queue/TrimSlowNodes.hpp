@@ -108,6 +108,13 @@ class TrimSlowNodes : public Queue {
 	int garbage2 = 9999999;
 	
   public:
+	Queue * createEmptyCopy() {
+		TrimSlowNodes * q = new TrimSlowNodes();
+		q->maxSize = this->maxSize;
+		q->targetSize = this->targetSize;
+		return q;
+	}
+	
 	int setArgs(char** argv) {
 		this->maxSize = atoi(argv[0]);
 		this->targetSize = atoi(argv[1]);
@@ -0,0 +1,208 @@
+#include "DeviceModel.hpp"
+#include "GateNode.hpp"
+#include "Latency.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <thread>
+using namespace std;
+
+DeviceModel::DeviceModel(int numQubits, const set<pair<int, int> > & couplings, Latency * lat, bool weighted) {
+	this->numQubits = numQubits;
+	
+	//Build adjacency matrix and swap list; a pair listed in both directions only gets one swap
+	this->rowWords = (numQubits + 63) / 64;
+	this->adjacency = new unsigned long long[numQubits * rowWords];
+	std::memset(this->adjacency, 0, sizeof(unsigned long long) * numQubits * rowWords);
+	vector<vector<pair<int, int> > > adjacent(numQubits);//(neighbor, swap index) for each qubit
+	for(auto iter = couplings.begin(); iter != couplings.end(); iter++) {
+		int a = (*iter).first;
+		int b = (*iter).second;
+		assert(a >= 0 && a < numQubits);
+		assert(b >= 0 && b < numQubits);
+		if(isCoupled(a, b)) {
+			continue;
+		}
+		adjacency[a * rowWords + (b >> 6)] |= 1ULL << (b & 63);
+		adjacency[b * rowWords + (a >> 6)] |= 1ULL << (a & 63);
+		adjacent[a].push_back(make_pair(b, (int) this->swaps.size()));
+		if(a != b) {
+			adjacent[b].push_back(make_pair(a, (int) this->swaps.size()));
+		}
+		
+		GateNode * g = new GateNode();
+		g->control = a;
+		g->target = b;
+		g->setType(GateType::SWP);
+		g->optimisticLatency = lat->getLatency(GateType::SWP, 2, g->target, g->control);
+		this->swaps.push_back(g);
+	}
+	
+	//Build neighbor lists:
+	this->neighborStart.resize(numQubits + 1);
+	this->neighborStart[0] = 0;
+	for(int x = 0; x < numQubits; x++) {
+		std::sort(adjacent[x].begin(), adjacent[x].end());
+		for(unsigned int y = 0; y < adjacent[x].size(); y++) {
+			this->neighbors.push_back(adjacent[x][y].first);
+			this->neighborSwaps.push_back(adjacent[x][y].second);
+		}
+		this->neighborStart[x + 1] = this->neighbors.size();
+	}
+	
+	this->swapUnit = lat->getLatency(GateType::SWP, 2, -1, -1);
+	assert(this->swapUnit > 0);
+	if(weighted) {
+		//measure in a unit that divides every swap latency, so each coupling's weight is exact;
+		//fall back on the cheapest swap (rounding each weight down) if that would overflow the distance matrix
+		int unit = 0;
+		int maxLatency = 0;
+		for(unsigned int x = 0; x < swaps.size(); x++) {
+			int l = swaps[x]->optimisticLatency;
+			for(int a = l; a > 0; ) {//unit = gcd(unit, l)
+				int r = unit % a;
+				unit = a;
+				a = r;
+			}
+			maxLatency = std::max(maxLatency, l);
+		}
+		if(unit > 0 && (long long) (maxLatency / unit) * (numQubits - 1) < UINT16_MAX) {
+			this->swapUnit = unit;
+		}
+	}
+	calcDistances(weighted);
+}
+
+DeviceModel::~DeviceModel() {
+	for(unsigned int x = 0; x < swaps.size(); x++) {
+		delete swaps[x];
+	}
+	delete [] adjacency;
+	delete [] distances8;
+	delete [] distances16;
+}
+
+//Breadth-first search from source; row[q] gets the number of hops from source to q
+void DeviceModel::hopsFrom(int source, int * row) {
+	for(int x = 0; x < numQubits; x++) {
+		row[x] = -1;
+	}
+	vector<int> frontier;
+	frontier.reserve(numQubits);
+	frontier.push_back(source);
+	row[source] = 0;
+	for(unsigned int head = 0; head < frontier.size(); head++) {
+		int q = frontier[head];
+		for(int x = neighborStart[q]; x < neighborStart[q + 1]; x++) {
+			int n = neighbors[x];
+			if(row[n] < 0) {
+				row[n] = row[q] + 1;
+				frontier.push_back(n);
+			}
+		}
+	}
+}
+
+//Dijkstra from source, weighting each coupling by its swap latency in units of swapUnit (rounded down).
+//The last coupling on the way to q hosts the gate itself rather than a swap, but any coupling on the path could end up playing that role,
+//so row[q] gets the cheapest path to q with its most expensive coupling free, plus one (so that adjacent qubits are at distance 1).
+//Rounding each coupling rather than the whole path keeps every swap a whole number of units, which the cost functions rely on
+//when they split the swaps between the two qubits.
+void DeviceModel::swapCostsFrom(int source, int * row) {
+	//state 2*q is "at q, haven't skipped a coupling yet", state 2*q+1 is "at q, already skipped one"
+	vector<int> cost(2 * numQubits, -1);
+	priority_queue<pair<int, int>, vector<pair<int, int> >, greater<pair<int, int> > > pending;
+	pending.push(make_pair(0, 2 * source));
+	while(!pending.empty()) {
+		int c = pending.top().first;
+		int state = pending.top().second;
+		pending.pop();
+		if(cost[state] >= 0) {
+			continue;
+		}
+		cost[state] = c;
+		
+		int q = state >> 1;
+		bool skipped = state & 1;
+		for(int x = neighborStart[q]; x < neighborStart[q + 1]; x++) {
+			int n = neighbors[x];
+			int weight = swaps[neighborSwaps[x]]->optimisticLatency / swapUnit;
+			if(cost[2 * n + skipped] < 0) {
+				pending.push(make_pair(c + weight, 2 * n + skipped));
+			}
+			if(!skipped && cost[2 * n + 1] < 0) {
+				pending.push(make_pair(c, 2 * n + 1));
+			}
+		}
+	}
+	
+	for(int x = 0; x < numQubits; x++) {
+		row[x] = (cost[2 * x + 1] < 0) ? -1 : cost[2 * x + 1] + 1;
+	}
+	row[source] = 0;
+}
+
+//Calculate distance between each pair of physical qubits, then store it in the narrowest type that fits
+void DeviceModel::calcDistances(bool weighted) {
+	vector<int> distances(numQubits * numQubits);
+	
+	//each source qubit is independent, so split them among threads on large devices:
+	int numThreads = std::min((int) std::thread::hardware_concurrency(), numQubits / 64);
+	if(numThreads < 1) {
+		numThreads = 1;
+	}
+	auto work = [&](int first) {
+		for(int x = first; x < numQubits; x += numThreads) {
+			if(weighted) {
+				swapCostsFrom(x, &distances[x * numQubits]);
+			} else {
+				hopsFrom(x, &distances[x * numQubits]);
+			}
+		}
+	};
+	vector<std::thread> threads;
+	for(int x = 1; x < numThreads; x++) {
+		threads.push_back(std::thread(work, x));
+	}
+	work(0);
+	for(unsigned int x = 0; x < threads.size(); x++) {
+		threads[x].join();
+	}
+	
+	//qubits with no path between them get the largest distance a connected device could have:
+	int maxDistance = 0;
+	this->diameter = 0;
+	for(int x = 0; x < numQubits; x++) {
+		for(int y = 0; y < numQubits; y++) {
+			int & d = distances[x * numQubits + y];
+			if(d < 0) {
+				d = numQubits - 1;
+			}
+			if(d > maxDistance) {
+				maxDistance = d;
+			}
+		}
+	}
+	for(int x = 0; x < numQubits - 1; x++) {
+		for(int y = x + 1; y < numQubits; y++) {
+			if(distances[x*numQubits + y] > this->diameter) {
+				this->diameter = distances[x*numQubits + y];
+			}
+		}
+	}
+	
+	if(maxDistance <= UINT8_MAX) {
+		this->distances8 = new uint8_t[numQubits * numQubits];
+		for(int x = 0; x < numQubits * numQubits; x++) {
+			this->distances8[x] = distances[x];
+		}
+	} else {
+		assert(maxDistance <= UINT16_MAX);
+		this->distances16 = new uint16_t[numQubits * numQubits];
+		for(int x = 0; x < numQubits * numQubits; x++) {
+			this->distances16[x] = distances[x];
+		}
+	}
+}
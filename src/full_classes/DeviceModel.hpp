@@ -0,0 +1,63 @@
+#ifndef DEVICEMODEL_HPP
+#define DEVICEMODEL_HPP
+
+#include <cstdint>
+#include <set>
+#include <vector>
+using namespace std;
+
+class GateNode;
+class Latency;
+
+/**
+ * Read-only view of the coupling map, built once before the search starts.
+ * Answers the questions the expanders and cost functions ask per node without touching a set:
+ * whether two physical qubits are coupled, how far apart they are, and who their neighbors are.
+ */
+class DeviceModel {
+  private:
+	int rowWords;//number of 64-bit words per row of the adjacency matrix
+	unsigned long long * adjacency;//numQubits rows of rowWords words; bit b of row a is set iff a and b are coupled
+	
+	//distance matrix; only one of these is allocated, depending on how large distances can get:
+	uint8_t * distances8 = 0;
+	uint16_t * distances16 = 0;
+	
+	void calcDistances(bool weighted);
+	void hopsFrom(int source, int * row);
+	void swapCostsFrom(int source, int * row);
+
+  public:
+	int numQubits;
+	int diameter;//largest distance between two physical qubits
+	int swapUnit;//cycles per unit of distance: the cheapest swap latency, or with weighted distances, a latency that divides every swap's
+	
+	//neighbor lists in CSR form: neighbors of qubit q are neighbors[neighborStart[q]] .. neighbors[neighborStart[q+1] - 1], ascending
+	vector<int> neighborStart;
+	vector<int> neighbors;
+	vector<int> neighborSwaps;//index into swaps of the swap gate joining q to each neighbor
+	
+	vector<GateNode*> swaps;//one swap gate per coupled pair, even if the coupling map lists both directions
+	
+	///If weighted is set, distances count each coupling's own swap latency, in units of swapUnit
+	DeviceModel(int numQubits, const set<pair<int, int> > & couplings, Latency * lat, bool weighted = false);
+	~DeviceModel();
+	
+	///Returns true iff physical qubits a and b are coupled (in either direction)
+	inline bool isCoupled(int a, int b) const {
+		return (adjacency[a * rowWords + (b >> 6)] >> (b & 63)) & 1;
+	}
+	
+	///Returns the minimal number of hops between distinct physical qubits a and b (min 1; numQubits-1 if they're disconnected).
+	///Either way, making a and b adjacent takes swaps worth at least distance(a,b)-1 units of swapUnit cycles,
+	///and each of those swaps takes a whole number of units, so the cost functions may split them between a and b.
+	///With weighted distances, the units count swap latency rather than swaps.
+	inline int distance(int a, int b) const {
+		if(distances8) {
+			return distances8[a * numQubits + b];
+		}
+		return distances16[a * numQubits + b];
+	}
+};
+
+#endif
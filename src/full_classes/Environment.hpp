@@ -3,9 +3,11 @@
 
 class GateNode;
 class CostFunc;
+class ScheduleLog;
 #include "Latency.hpp"
 #include "Filter.hpp"
 #include "NodeMod.hpp"
+#include "DeviceModel.hpp"
 #include <set>
 #include <vector>
 #include <cassert>
@@ -25,10 +27,9 @@ class Environment {//for data shared across all nodes
 	vector<Filter*> filters;
 	CostFunc * cost;//contains function to calculate a node's cost
 	Latency * latency;//contains function to calculate a gate's latency
+	ScheduleLog * schedule;//holds every node's scheduled gates
 	
-	set<pair<int, int> > couplings; //the coupling map (as a list of qubit-pairs)
-	GateNode ** possibleSwaps; //list of swaps implied by the coupling map
-	int * couplingDistances;//array of size (numPhysicalQubits*numPhysicalQubits), containing the minimal number of hops between each pair of qubits in the coupling graph
+	DeviceModel * device;//the coupling map: adjacency, distances between physical qubits, and the swaps it implies
 	
 	int numLogicalQubits;//number of logical qubits in circuit; if there's a gap then this includes unused qubits
 	int numPhysicalQubits;//number of physical qubits in the coupling map
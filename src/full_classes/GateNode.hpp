@@ -1,17 +1,38 @@
 #ifndef GATENODE_HPP
 #define GATENODE_HPP
 
+#include "GateType.hpp"
 #include <string>
+#include <vector>
 using namespace std;
 
 class GateNode { //part of a DAG of nodes
   public:
-	string name;
+	static vector<GateNode*> gates;//every gate node ever created, indexed by id
+	unsigned int id;//index in gates
+	
+	GateNode() {
+		this->id = gates.size();
+		gates.push_back(this);
+	}
+	
+	void setType(int type) {
+		this->type = type;
+		this->isSwap = (type == GateType::SWP);
+	}
+	
+	const string & name() const {
+		return GateType::name(this->type);
+	}
+	
+	int type;//gate name's id (see GateType)
+	bool isSwap = false;//true iff this is a swp gate, i.e. its qubits are physical rather than logical
 	int control;//control qubit, or -1
 	int target;//target qubit
 	
 	int optimisticLatency;//how many cycles this gate takes, assuming it uses the fastest physical qubit(s)
 	int criticality;//length (time) of circuit from here until furthest leaf
+	int numParents = 0;//number of distinct gates this one directly depends on
 	
 	//note that the following variables will not take into account inserted SWP gates
 	GateNode * controlChild = 0;//gate which depends on this one's control qubit, or NULL
@@ -21,6 +42,10 @@ class GateNode { //part of a DAG of nodes
 	
 	GateNode * nextControlCNOT = 0;//next 2-qubit gate which depends on this one's control, or -1
 	GateNode * nextTargetCNOT = 0;//next 2-qubit gate which depends on this one's target, or -1
+	
+	//total optimistic latency of the 1-qubit gates between this gate and nextControlCNOT/nextTargetCNOT (or the end of the circuit)
+	int controlChainLatency = 0;
+	int targetChainLatency = 0;
 };
 
 #endif
@@ -0,0 +1,125 @@
+#ifndef GATESET_HPP
+#define GATESET_HPP
+
+#include "GateNode.hpp"
+#include <cassert>
+#include <cstring>
+using namespace std;
+
+/**
+ * A small set of gates, stored as a sorted array of gate ids.
+ * The array lives in storage supplied by the owner (a node keeps it inline, right after its own fields).
+ * Copying one is a plain memcpy and comparing two is a memcmp, which matters since every node carries one.
+ * Iterating yields GateNode pointers in id order (which is the gates' order in the original circuit).
+ */
+class GateSet {
+  private:
+	int num = 0;
+	int capacity = 0;
+	unsigned int * ids = 0;
+
+  public:
+	GateSet() {}
+	GateSet(const GateSet & other) = delete;
+	
+	///Use the specified array (with room for capacity ids) to hold this set's contents
+	inline void setStorage(unsigned int * storage, int capacity) {
+		this->ids = storage;
+		this->capacity = capacity;
+		this->num = 0;
+	}
+	
+	///Copies the other set's contents into this set's storage
+	inline GateSet & operator=(const GateSet & other) {
+		assert(other.num <= capacity);
+		num = other.num;
+		std::memcpy(ids, other.ids, num * sizeof(unsigned int));
+		return *this;
+	}
+	
+	class iterator {
+	  private:
+		const unsigned int * pos;
+	
+	  public:
+		iterator(const unsigned int * pos) {
+			this->pos = pos;
+		}
+		inline GateNode * operator*() const {
+			return GateNode::gates[*pos];
+		}
+		inline iterator & operator++() {
+			pos++;
+			return *this;
+		}
+		inline iterator operator++(int) {
+			iterator ret = *this;
+			pos++;
+			return ret;
+		}
+		inline bool operator==(const iterator & other) const {
+			return pos == other.pos;
+		}
+		inline bool operator!=(const iterator & other) const {
+			return pos != other.pos;
+		}
+	};
+	
+	inline iterator begin() const {
+		return iterator(ids);
+	}
+	
+	inline iterator end() const {
+		return iterator(ids + num);
+	}
+	
+	inline int size() const {
+		return num;
+	}
+	
+	///Sets the number of gates, for when the owner has already copied the ids into this set's storage
+	inline void setSize(int num) {
+		assert(num <= capacity);
+		this->num = num;
+	}
+	
+	///Add the specified gate; returns false if it was already in the set
+	bool insert(GateNode * g) {
+		unsigned int id = g->id;
+		int x = num;
+		while(x > 0 && ids[x - 1] > id) {
+			x--;
+		}
+		if(x > 0 && ids[x - 1] == id) {
+			return false;
+		}
+		assert(num < capacity);
+		std::memmove(ids + x + 1, ids + x, (num - x) * sizeof(unsigned int));
+		ids[x] = id;
+		num++;
+		return true;
+	}
+	
+	///Remove the specified gate; returns the number of gates removed (0 or 1)
+	int erase(GateNode * g) {
+		unsigned int id = g->id;
+		for(int x = 0; x < num; x++) {
+			if(ids[x] == id) {
+				std::memmove(ids + x, ids + x + 1, (num - x - 1) * sizeof(unsigned int));
+				num--;
+				return 1;
+			}
+		}
+		return 0;
+	}
+	
+	inline bool operator==(const GateSet & other) const {
+		return num == other.num && !std::memcmp(ids, other.ids, num * sizeof(unsigned int));
+	}
+	
+	inline bool operator!=(const GateSet & other) const {
+		return !(*this == other);
+	}
+};
+
+#endif
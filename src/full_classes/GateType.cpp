@@ -0,0 +1,7 @@
+#include "GateType.hpp"
+using namespace std;
+
+const int GateType::SWP;
+const int GateType::SWP_UPPER;
+vector<string> GateType::names = {"swp", "SWP"};
+unordered_map<string, int> GateType::ids = {{"swp", GateType::SWP}, {"SWP", GateType::SWP_UPPER}};
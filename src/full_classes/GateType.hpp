@@ -0,0 +1,52 @@
+#ifndef GATETYPE_HPP
+#define GATETYPE_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+/**
+ * Symbol table for gate names.
+ * Each distinct name gets a small dense id the first time it's interned (by the qasm parser, a latency table, etc.),
+ * so everything past parsing can compare and look up gates by id instead of by string.
+ * Not thread-safe: intern every name before the search starts.
+ */
+class GateType {
+  private:
+	static vector<string> names;
+	static unordered_map<string, int> ids;
+	
+  public:
+	static const int SWP = 0;//"swp", the swap gates inserted by the mapper
+	static const int SWP_UPPER = 1;//"SWP"
+	
+	///Returns the id for the specified gate name, assigning a new one if we haven't seen it before
+	static int intern(const char * name) {
+		auto search = ids.find(name);
+		if(search != ids.end()) {
+			return search->second;
+		}
+		int id = names.size();
+		names.push_back(name);
+		ids.emplace(name, id);
+		return id;
+	}
+	
+	///Returns the gate name with the specified id
+	static const string & name(int id) {
+		return names[id];
+	}
+	
+	///Returns the number of gate types interned so far
+	static int count() {
+		return names.size();
+	}
+	
+	///Returns true iff the specified gate type is spelled like a swap
+	static bool isSwapName(int id) {
+		return id == SWP || id == SWP_UPPER;
+	}
+};
+
+#endif
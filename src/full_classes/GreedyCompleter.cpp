@@ -0,0 +1,179 @@
+#include "GreedyCompleter.hpp"
+#include "Queue.hpp"
+#include "Expander.hpp"
+#include "DeviceModel.hpp"
+#include "CostFunc.hpp"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+using namespace std;
+
+/**
+ * The queue GreedyCompleter hands to the expander.
+ * It keeps only the best node pushed into it, deletes the rest, and skips the filters.
+ * On ties it keeps the node that scheduled more gates: the expander pushes the child that schedules nothing first,
+	and it often costs the same as the swaps that make progress, so keeping it would idle until the step limit.
+ */
+class GreedyCompleterSink : public Queue {
+  private:
+	Node * best = 0;
+	
+	bool pushNode(Node * newNode) {
+		assert(false);
+		return false;
+	}
+	
+	static bool isBetter(Node * a, Node * b) {
+		if(a->numUnscheduledGates != b->numUnscheduledGates) {
+			return a->numUnscheduledGates < b->numUnscheduledGates;
+		}
+		if(a->cost != b->cost) {
+			return a->cost < b->cost;
+		}
+		return a->numScheduled > b->numScheduled;
+	}
+	
+  public:
+	Queue * createEmptyCopy() {
+		return new GreedyCompleterSink();
+	}
+	
+	bool push(Node * newNode) {
+		numPushed++;
+		if(!best) {
+			best = newNode;
+		} else if(isBetter(newNode, best)) {
+			delete best;
+			best = newNode;
+		} else {
+			delete newNode;
+		}
+		return true;
+	}
+	
+	Node * pop() {
+		numPopped++;
+		Node * ret = best;
+		best = 0;
+		return ret;
+	}
+	
+	int size() {
+		return best ? 1 : 0;
+	}
+};
+
+GreedyCompleter::GreedyCompleter(Expander * expander) {
+	this->expander = expander;
+}
+
+//Breadth-first search from physical qubit b until we reach a; returns the number of hops between them (or -1 if disconnected).
+//hops[q] gets the number of hops from q to b, for every qubit q at most that far.
+static int hopsBetween(DeviceModel * device, int a, int b, vector<int> & hops) {
+	hops.assign(device->numQubits, -1);
+	vector<int> frontier(1, b);
+	hops[b] = 0;
+	for(unsigned int head = 0; head < frontier.size() && hops[a] < 0; head++) {
+		int q = frontier[head];
+		for(int x = device->neighborStart[q]; x < device->neighborStart[q + 1]; x++) {
+			int n = device->neighbors[x];
+			if(hops[n] < 0) {
+				hops[n] = hops[q] + 1;
+				frontier.push_back(n);
+			}
+		}
+	}
+	return hops[a];
+}
+
+//The first of node's ready 2-qubit gates whose qubits aren't coupled (but could be), or NULL
+static GateNode * firstBlockedGate(Node * node) {
+	DeviceModel * device = node->env->device;
+	vector<int> hops;
+	for(auto iter = node->readyGates.begin(); iter != node->readyGates.end(); iter++) {
+		GateNode * g = *iter;
+		if(g->control >= 0 && hopsBetween(device, node->laq[g->control], node->laq[g->target], hops) > 1) {
+			return g;
+		}
+	}
+	return NULL;
+}
+
+//A child of node that brings the specified gate one hop closer, by swapping its control's qubit toward its target's along a shortest path;
+//or, if there's no such gate or those qubits are busy, a child that just waits.
+Node * GreedyCompleter::routeStep(Node * node, GateNode * blocked) {
+	DeviceModel * device = node->env->device;
+	Node * child = node->prepChild();
+	
+	if(blocked) {
+		int control = node->laq[blocked->control];
+		vector<int> hops;
+		hopsBetween(device, control, node->laq[blocked->target], hops);
+		for(int x = device->neighborStart[control]; x < device->neighborStart[control + 1]; x++) {
+			if(hops[device->neighbors[x]] == hops[control] - 1) {
+				child->scheduleGate(device->swaps[device->neighborSwaps[x]]);//fails (so we wait) if either qubit is busy
+				break;
+			}
+		}
+	}
+	
+	child->cost = node->env->cost->getCost(child);
+	return child;
+}
+
+Node * GreedyCompleter::complete(Node * start) {
+	assert(start->readyGates.size());
+	Environment * env = start->env;
+	
+	//each gate shouldn't need more than a diameter's worth of swaps, each of which we may have to wait out;
+	//anything much longer means something's wrong
+	int slowest = 1;
+	for(unsigned int x = 0; x < env->device->swaps.size(); x++) {
+		slowest = std::max(slowest, env->device->swaps[x]->optimisticLatency);
+	}
+	for(unsigned int x = 0; x < GateNode::gates.size(); x++) {
+		slowest = std::max(slowest, GateNode::gates[x]->optimisticLatency);
+	}
+	long maxSteps = 2L * (env->numGates + 1) * (env->device->diameter + 1) * (slowest + 1);
+	
+	GreedyCompleterSink sink;
+	vector<Node*> path;
+	Node * current = start;
+	Node * result = NULL;
+	for(long step = 0; step < maxSteps; step++) {
+		Node * parent = current;
+		expander->expand(&sink, parent);
+		current = sink.pop();
+		
+		//the cost function alone can lead us around in circles, swapping qubits back and forth,
+		//so unless the best child gets some gate of the circuit done or brings the first blocked gate closer, we route that gate ourselves
+		//(except while we're still picking the initial mapping, where children never schedule gates):
+		if(!current || (parent->cycle >= -1 && current->numUnscheduledGates == parent->numUnscheduledGates)) {
+			GateNode * blocked = firstBlockedGate(parent);
+			vector<int> hops;
+			if(!current || !blocked ||
+			   hopsBetween(env->device, current->laq[blocked->control], current->laq[blocked->target], hops) >=
+			   hopsBetween(env->device, parent->laq[blocked->control], parent->laq[blocked->target], hops)) {
+				delete current;
+				current = routeStep(parent, blocked);
+			}
+		}
+		path.push_back(current);
+		if(!current->readyGates.size()) {
+			result = current;
+			break;
+		}
+	}
+	
+	//children's schedules build on their parents' log entries, so deleting the path (except its end) keeps the result intact
+	for(unsigned int x = 0; x < path.size(); x++) {
+		if(path[x] != result) {
+			delete path[x];
+		}
+	}
+	if(result) {
+		result->parent = NULL;
+	}
+	
+	return result;
+}
@@ -0,0 +1,32 @@
+#ifndef GREEDYCOMPLETER_HPP
+#define GREEDYCOMPLETER_HPP
+
+#include "Node.hpp"
+class Expander;
+using namespace std;
+
+/**
+ * Finishes a partial schedule greedily.
+ * Starting from some node, it expands the current node and moves on to its best child (fewest unscheduled gates, then lowest cost, then most gates scheduled),
+	until every gate is scheduled.
+ * When that child neither schedules any of the circuit's gates nor brings the first blocked 2-qubit gate's qubits closer,
+	it instead swaps that gate's qubits one hop closer itself (see routeStep),
+	so every gate gets done even when the cost function doesn't tell swaps apart.
+ * The nodes it creates never go through the filters, and all but the final one are deleted before it returns,
+	so it can run in the middle of a search without disturbing it.
+ */
+class GreedyCompleter {
+  private:
+	Expander * expander;
+	
+	Node * routeStep(Node * node, GateNode * blocked);
+
+  public:
+	GreedyCompleter(Expander * expander);
+	
+	///Returns a final node descending from start (which must not be a final node itself), or NULL if the expander got stuck.
+	///The caller owns the returned node; its parent is set to NULL, since the nodes between it and start are gone.
+	Node * complete(Node * start);
+};
+
+#endif
@@ -0,0 +1,322 @@
+#include "HDAStar.hpp"
+#include "Queue.hpp"
+#include "Expander.hpp"
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <thread>
+using namespace std;
+
+/**
+ * The queue each worker hands to the expander.
+ * Instead of holding nodes itself, it sends each pushed node to the worker that owns it.
+ */
+class HDAStarRouter : public Queue {
+  private:
+	HDAStar * search;
+	int id;//the worker using this router
+	
+	bool pushNode(Node * newNode) {
+		assert(false);
+		return false;
+	}
+
+  public:
+	HDAStarRouter(HDAStar * search, int id) {
+		this->search = search;
+		this->id = id;
+	}
+	
+	Queue * createEmptyCopy() {
+		return new HDAStarRouter(search, id);
+	}
+	
+	bool push(Node * newNode) {
+		return search->route(id, newNode);
+	}
+	
+	Node * pop() {
+		assert(false && "the expander shouldn't pop nodes");
+		return 0;
+	}
+	
+	//Expanders use this to tell whether they're expanding the root node, so we report the whole search's size
+	int size() {
+		return (int) search->numPending();
+	}
+	
+	void setBestFinalNode(Node * n) {
+		this->bestFinalNode = n;
+	}
+};
+
+HDAStar::HDAStar(Environment * env, Queue * queuePrototype, Expander * expander, int numThreads, unsigned int retainPopped) {
+	this->env = env;
+	this->expander = expander;
+	this->numThreads = numThreads;
+	this->retainPopped = retainPopped;
+	this->bestCost = INT_MAX;
+	this->numInFlight = 0;
+	this->done = false;
+	
+	for(int x = 0; x < numThreads; x++) {
+		Worker * w = new Worker;
+		
+		//each worker gets its own shard of every filter:
+		w->env = new Environment(*env);
+		for(unsigned int y = 0; y < w->env->filters.size(); y++) {
+			w->env->filters[y] = env->filters[y]->createEmptyCopy();
+		}
+		
+		w->queue = queuePrototype->createEmptyCopy();
+		w->router = new HDAStarRouter(this, x);
+		w->outbox.resize(numThreads);
+		w->queued = 0;
+		workers.push_back(w);
+	}
+}
+
+HDAStar::~HDAStar() {
+	for(int x = 0; x < numThreads; x++) {
+		Worker * w = workers[x];
+		while(w->queue->size()) {
+			Node * n = w->queue->pop();
+			delete n;
+		}
+		while(w->oldNodes.size() > 0) {
+			Node * n = w->oldNodes.front();
+			w->oldNodes.pop_front();
+			delete n;
+		}
+		for(unsigned int y = 0; y < w->env->filters.size(); y++) {
+			delete w->env->filters[y];
+		}
+		delete w->queue;
+		delete w->router;
+		delete w->env;
+		delete w;
+	}
+}
+
+//The owner depends only on the qubit mapping, since the filters compare nodes with the same mapping at any cycle.
+//That way every pair of nodes a filter would compare in a serial search still meet in the same shard.
+int HDAStar::owner(Node * n) {
+	std::size_t hash = n->mappingHash;
+	
+	//mix the bits so nearby hash values don't pile onto the same worker:
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return (int) (hash % numThreads);
+}
+
+bool HDAStar::route(int from, Node * n) {
+	int to = owner(n);
+	Worker * w = workers[from];
+	if(to == from) {
+		n->env = w->env;
+		bool success = w->queue->push(n);
+		w->queued = w->queue->size();
+		return success;
+	}
+	w->outbox[to].push_back(n);
+	return true;
+}
+
+long HDAStar::numPending() {
+	long total = numInFlight;
+	for(int x = 0; x < numThreads; x++) {
+		total += workers[x]->queued;
+	}
+	return total;
+}
+
+//send everything in w's outbox to the nodes' owners
+void HDAStar::flushOutbox(Worker * w) {
+	for(int x = 0; x < numThreads; x++) {
+		std::vector<Node*> & out = w->outbox[x];
+		if(out.empty()) {
+			continue;
+		}
+		
+		//count the nodes as in flight before the receiver can possibly see them:
+		numInFlight += out.size();
+		
+		Worker * dest = workers[x];
+		{
+			std::lock_guard<std::mutex> lock(dest->inboxLock);
+			dest->inbox.insert(dest->inbox.end(), out.begin(), out.end());
+		}
+		dest->inboxSignal.notify_one();
+		out.clear();
+	}
+}
+
+//push nodes sent by other workers into w's queue
+void HDAStar::receive(Worker * w, std::vector<Node*> & incoming) {
+	for(unsigned int x = 0; x < incoming.size(); x++) {
+		Node * n = incoming[x];
+		n->env = w->env;
+		if(!w->queue->push(n)) {
+			delete n;
+		}
+	}
+	w->queued = w->queue->size();
+	
+	//only now that the nodes are in our queue can they stop counting as in flight:
+	numInFlight -= incoming.size();
+	incoming.clear();
+}
+
+void HDAStar::offerFinalNode(Node * n) {
+	std::lock_guard<std::mutex> lock(bestLock);
+	if(!bestFinalNode || n->cost < bestFinalNode->cost) {
+		bestFinalNode = n;
+		bestCost = n->cost;
+	}
+}
+
+void HDAStar::stopAll() {
+	done = true;
+	for(int x = 0; x < numThreads; x++) {
+		std::lock_guard<std::mutex> lock(workers[x]->inboxLock);
+		workers[x]->inboxSignal.notify_all();
+	}
+}
+
+void HDAStar::work(int id) {
+	Worker * w = workers[id];
+	bool idle = false;
+	std::vector<Node*> incoming;
+	
+	while(true) {
+		{
+			std::lock_guard<std::mutex> lock(w->inboxLock);
+			incoming.swap(w->inbox);
+		}
+		if(!incoming.empty()) {
+			if(idle) {
+				//we must stop counting as idle before the new nodes stop counting as in flight
+				std::lock_guard<std::mutex> lock(termLock);
+				numIdle--;
+				idle = false;
+			}
+			receive(w, incoming);
+		}
+		
+		Node * n = 0;
+		if(w->queue->size() > 0) {
+			n = w->queue->pop();
+			w->queued = w->queue->size();
+			n->expanded = true;
+			
+			Node * finalNode = w->queue->getBestFinalNode();
+			if(finalNode && finalNode->cost < bestCost) {
+				offerFinalNode(finalNode);
+			}
+			
+			if(n->dead) {
+				//final nodes are never deleted during the search, since other workers may be looking at them
+				if(n->readyGates.size() == 0) {
+					w->oldNodes.push_back(n);
+				} else {
+					w->env->deleteRecord(n);
+					delete n;
+				}
+				continue;
+			}
+			
+			if(n->cost >= bestCost) {
+				//every node left in our queue is at least this expensive
+				w->oldNodes.push_back(n);
+				n = 0;
+			}
+		}
+		
+		if(!n) {
+			{
+				std::lock_guard<std::mutex> lock(termLock);
+				if(!idle) {
+					idle = true;
+					numIdle++;
+				}
+				if(numIdle == numThreads && numInFlight == 0) {
+					done = true;
+				}
+			}
+			if(done) {
+				stopAll();
+				return;
+			}
+			
+			std::unique_lock<std::mutex> lock(w->inboxLock);
+			w->inboxSignal.wait(lock, [&]{return done || !w->inbox.empty();});
+			if(done) {
+				return;
+			}
+			continue;
+		}
+		
+		unsigned int numChecked = 0;
+		while(retainPopped && w->oldNodes.size() > retainPopped && numChecked++ < w->oldNodes.size()) {
+			Node * pop = w->oldNodes.front();
+			w->oldNodes.pop_front();
+			if(pop->readyGates.size() == 0) {
+				w->oldNodes.push_back(pop);
+			} else {
+				w->env->deleteRecord(pop);
+				delete pop;
+			}
+		}
+		
+		w->oldNodes.push_back(n);
+		w->numPopped++;
+		
+		{
+			std::lock_guard<std::mutex> lock(bestLock);
+			w->router->setBestFinalNode(bestFinalNode);
+		}
+		expander->expand(w->router, n);
+		flushOutbox(w);
+	}
+}
+
+Node * HDAStar::run(Node * root) {
+	Worker * w = workers[owner(root)];
+	root->env = w->env;
+	w->queue->push(root);
+	w->queued = w->queue->size();
+	
+	std::vector<std::thread> threads;
+	for(int x = 0; x < numThreads; x++) {
+		threads.push_back(std::thread(&HDAStar::work, this, x));
+	}
+	for(int x = 0; x < numThreads; x++) {
+		threads[x].join();
+	}
+	
+	return bestFinalNode;
+}
+
+int HDAStar::getNumPopped() {
+	int total = 0;
+	for(int x = 0; x < numThreads; x++) {
+		total += workers[x]->numPopped;
+	}
+	return total;
+}
+
+int HDAStar::size() {
+	int total = 0;
+	for(int x = 0; x < numThreads; x++) {
+		total += workers[x]->queue->size();
+	}
+	return total;
+}
+
+void HDAStar::printFilterStats(std::ostream & stream) {
+	for(int x = 0; x < numThreads; x++) {
+		stream << "//Worker " << x << " popped " << workers[x]->numPopped << " nodes.\n";
+		workers[x]->env->printFilterStats(stream);
+	}
+}
@@ -0,0 +1,97 @@
+#ifndef HDASTAR_HPP
+#define HDASTAR_HPP
+
+#include "Node.hpp"
+#include "Environment.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <vector>
+class Queue;
+class Expander;
+class HDAStarRouter;
+using namespace std;
+
+/**
+ * Hash-distributed A* search.
+ * Each worker thread owns its own queue and its own copy of the filters (a shard).
+ * Child nodes are sent to the worker picked by hashing their qubit mapping alone,
+	so states the filters would compare (same mapping, any cycle) always meet in the same filter shard.
+ * So a child that doesn't swap always stays on its parent's worker; only swap children spread across threads.
+	How well the search scales with -threads therefore depends on how many of the expanded children swap.
+ * Workers share the best final node's cost so they can stop expanding nodes that can't improve on it.
+ */
+class HDAStar {
+  private:
+	struct Worker {
+		Environment * env;//copy of the main environment, with this worker's own filters
+		Queue * queue;//this worker's open list
+		HDAStarRouter * router;//the queue we hand to the expander; it forwards children to their owners
+		
+		std::mutex inboxLock;
+		std::condition_variable inboxSignal;
+		std::vector<Node*> inbox;//nodes sent here by other workers
+		std::vector<std::vector<Node*> > outbox;//nodes waiting to be sent to each other worker
+		
+		std::deque<Node*> oldNodes;//popped nodes we're keeping around for the filters
+		std::atomic<int> queued;//size of this worker's queue, readable by other workers
+		int numPopped = 0;
+	};
+	
+	Environment * env;
+	Expander * expander;
+	unsigned int retainPopped;
+	int numThreads;
+	std::vector<Worker*> workers;
+	
+	//best final node found by any worker:
+	std::mutex bestLock;
+	Node * bestFinalNode = 0;
+	std::atomic<int> bestCost;
+	
+	//termination detection:
+	std::mutex termLock;
+	int numIdle = 0;//number of workers with nothing left worth expanding
+	std::atomic<long> numInFlight;//number of nodes sitting in inboxes
+	std::atomic<bool> done;
+	
+	void work(int id);
+	void receive(Worker * w, std::vector<Node*> & incoming);
+	void flushOutbox(Worker * w);
+	void stopAll();
+	void offerFinalNode(Node * n);
+
+  public:
+	HDAStar(Environment * env, Queue * queuePrototype, Expander * expander, int numThreads, unsigned int retainPopped);
+	~HDAStar();
+	
+	///Pick the worker responsible for the specified node
+	int owner(Node * n);
+	
+	///Called by a worker's router for each child node; returns false iff the node was rejected (caller deletes it)
+	bool route(int from, Node * n);
+	
+	///Search from the specified root node until no worker has a node cheaper than the best final node
+	///Returns the best final node
+	Node * run(Node * root);
+	
+	inline Node * getBestFinalNode() {
+		return bestFinalNode;
+	}
+	
+	///Total number of nodes popped by the workers
+	int getNumPopped();
+	
+	///Total number of nodes left in the workers' queues
+	int size();
+	
+	///Number of nodes that still await expansion anywhere in the search
+	long numPending();
+	
+	///Print each shard's filter statistics
+	void printFilterStats(std::ostream & stream);
+};
+
+#endif
@@ -0,0 +1,197 @@
+#include "IDAStar.hpp"
+#include "Queue.hpp"
+#include "Expander.hpp"
+#include "ScheduleLog.hpp"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+using namespace std;
+
+extern bool _verbose;
+
+/**
+ * The queue IDAStar hands to the expander.
+ * It collects the children of the node being expanded, and skips the filters.
+ */
+class IDAStarSink : public Queue {
+  private:
+	bool pushNode(Node * newNode) {
+		assert(false);
+		return false;
+	}
+
+  public:
+	std::vector<Node*> children;
+	bool expandingRoot = false;
+	
+	Queue * createEmptyCopy() {
+		return new IDAStarSink();
+	}
+	
+	bool push(Node * newNode) {
+		numPushed++;
+		children.push_back(newNode);
+		return true;
+	}
+	
+	Node * pop() {
+		assert(false && "the expander shouldn't pop nodes");
+		return 0;
+	}
+	
+	//Expanders use this to tell whether they're expanding the root node; other than that, the nodes on our path are still pending
+	int size() {
+		return expandingRoot ? 0 : 1;
+	}
+};
+
+//cheapest first, with fewer unscheduled gates as tiebreaker
+static bool cheaperNode(const Node * lhs, const Node * rhs) {
+	if(lhs->cost == rhs->cost) {
+		return lhs->numUnscheduledGates < rhs->numUnscheduledGates;
+	}
+	return lhs->cost < rhs->cost;
+}
+
+IDAStar::IDAStar(Environment * env, Expander * expander, long tableSize) {
+	this->env = env;
+	this->expander = expander;
+	this->sink = new IDAStarSink();
+	
+	uint64_t size = 1;
+	while(size < (uint64_t) tableSize) {
+		size <<= 1;
+	}
+	this->table.resize(size);
+	this->mask = size - 1;
+}
+
+IDAStar::~IDAStar() {
+	delete sink;
+}
+
+//Combine the node's hash of its qubit mapping and ready gates with how many more cycles each physical qubit is busy
+uint64_t IDAStar::stateKey(Node * n) {
+	uint64_t hash = n->stateHash();
+	for(int x = 0; x < env->numPhysicalQubits; x++) {
+		int busy = n->busyCycles(x);
+		if(busy) {
+			hash ^= Node::mix64(((uint64_t) x << 32) | busy) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+		}
+	}
+	
+	//finish with a 64-bit mixer, so we can index the table with the low bits:
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+//A hash of the same state as stateKey, computed from scratch (FNV-1a over the mapping, busy cycles, and ready gates),
+//so a collision in stateKey is very unlikely to collide here too
+uint64_t IDAStar::stateCheck(Node * n) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for(int x = 0; x < env->numPhysicalQubits; x++) {
+		hash = (hash ^ (uint64_t) (uint16_t) n->qal[x]) * 0x100000001b3ULL;
+		hash = (hash ^ (uint64_t) n->busyCycles(x)) * 0x100000001b3ULL;
+	}
+	for(GateNode * g : n->readyGates) {
+		hash = (hash ^ g->id) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+//Search below n, which costs no more than the threshold.
+//Returns a final node if we reach one; otherwise sets bound to the lowest cost above the threshold in n's subtree (INT_MAX if none).
+Node * IDAStar::probe(Node * n, int & bound) {
+	sink->expandingRoot = !n->parent;
+	expander->expand(sink, n);
+	numExpanded++;
+	
+	std::vector<Node*> children;
+	children.swap(sink->children);
+	std::vector<Node*> order(children);
+	std::stable_sort(order.begin(), order.end(), cheaperNode);
+	
+	bound = INT_MAX;
+	Node * found = NULL;
+	for(unsigned int x = 0; x < order.size() && !found; x++) {
+		Node * child = order[x];
+		if(child->cost > threshold) {
+			//the rest are even more expensive
+			bound = std::min(bound, child->cost);
+			break;
+		}
+		if(!child->readyGates.size()) {
+			found = child;
+			break;
+		}
+		
+		uint64_t key = stateKey(child);
+		uint64_t check = stateCheck(child);
+		Entry & entry = table[key & mask];
+		if(entry.key == key && entry.check != check) {
+			numCollisions++;
+		} else if(entry.key == key && entry.cycle <= child->cycle && entry.bound > threshold) {
+			//we've already been here, no later than now, and found nothing within the threshold
+			numHits++;
+			bound = std::min(bound, entry.bound);
+			continue;
+		}
+		
+		int childBound;
+		found = probe(child, childBound);
+		if(!found) {
+			bound = std::min(bound, childBound);
+			Entry & slot = table[key & mask];
+			slot.key = key;
+			slot.check = check;
+			slot.cycle = child->cycle;
+			slot.bound = childBound;
+		}
+	}
+	
+	//the schedule log takes back the entries of the children we're done with:
+	for(Node * child : children) {
+		if(child != found) {
+			delete child;
+		}
+	}
+	
+	return found;
+}
+
+Node * IDAStar::run(Node * root) {
+	assert(root->readyGates.size());
+	threshold = root->cost;
+	
+	while(true) {
+		numIterations++;
+		if(_verbose) {
+			std::cerr << "dbg msg: IDA* iteration " << numIterations << " with threshold " << threshold << "; " << numExpanded << " nodes expanded so far.\n";
+		}
+		
+		int bound;
+		Node * found = probe(root, bound);
+		if(found) {
+			found->parent = NULL;
+			return found;
+		}
+		if(bound == INT_MAX) {
+			return NULL;
+		}
+		threshold = bound;
+		
+		//only the root is left, so the log can start over (unless the root's schedule lives in it):
+		if(!root->scheduled) {
+			env->schedule->clear();
+		}
+	}
+}
+
+void IDAStar::printStatistics(std::ostream & stream) {
+	stream << "//IDA* ran " << numIterations << " iterations; the last one had threshold " << threshold << ".\n";
+	stream << "//IDA* transposition table has " << table.size() << " entries (" << table.size() * sizeof(Entry) << " bytes), and saved " << numHits << " subtree searches; " << numCollisions << " key collisions were caught.\n";
+}
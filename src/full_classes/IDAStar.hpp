@@ -0,0 +1,70 @@
+#ifndef IDASTAR_HPP
+#define IDASTAR_HPP
+
+#include "Node.hpp"
+#include "Environment.hpp"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+class Expander;
+class IDAStarSink;
+using namespace std;
+
+/**
+ * Iterative-deepening A* search, for circuits whose open list wouldn't fit in memory.
+ * Each iteration runs depth-first from the root, expanding only nodes whose cost is at most the iteration's threshold;
+	the next iteration's threshold is the lowest cost that went over this one.
+	The first final node we reach is optimal (as long as the cost function never overestimates).
+ * Memory use doesn't grow with the search: it's the nodes along the current path (and their children),
+	plus a fixed-size transposition table.
+ * The table is keyed on each node's qubit mapping and frontier (ready gates and how long each qubit is busy).
+	Each entry also keeps a second, independently computed hash of that state; we only trust an entry if both match.
+	After a subtree comes up empty, we store the lowest cost that went over the threshold inside it;
+	reaching the same state again, no earlier than before, then only needs a look at the table.
+ * Nodes never go through the filters, since we delete them as soon as we back out of them.
+ */
+class IDAStar {
+  private:
+	struct Entry {
+		uint64_t key = 0;
+		uint64_t check = 0;//second hash of the same state, computed independently of key, to catch key collisions
+		int cycle = 0;
+		int bound = 0;//lowest cost above the threshold in this state's subtree
+	};
+	
+	Environment * env;
+	Expander * expander;
+	IDAStarSink * sink;//the queue we hand to the expander; it just collects the children
+	
+	std::vector<Entry> table;
+	uint64_t mask;//table size minus one
+	
+	int threshold = 0;
+	int numIterations = 0;
+	long numExpanded = 0;
+	long numHits = 0;//nodes skipped thanks to the table
+	long numCollisions = 0;//entries whose key matched but whose check didn't
+	
+	uint64_t stateKey(Node * n);
+	uint64_t stateCheck(Node * n);
+	Node * probe(Node * n, int & bound);
+
+  public:
+	///tableSize is the number of transposition table entries (rounded up to a power of 2)
+	IDAStar(Environment * env, Expander * expander, long tableSize);
+	~IDAStar();
+	
+	///Search from the specified root node until we reach a final node, or run out of nodes
+	///Returns the final node (owned by the caller, with its parent set to NULL), or NULL if there's none
+	Node * run(Node * root);
+	
+	///Number of nodes expanded over all iterations
+	inline long getNumExpanded() {
+		return numExpanded;
+	}
+	
+	///Print statistics about the iterations and the transposition table
+	void printStatistics(std::ostream & stream);
+};
+
+#endif
@@ -1,25 +1,107 @@
 #include "Node.hpp"
 #include <set>
 #include <cassert>
+#include <climits>
+#include <cstring>
 #include <iostream>
 using namespace std;
 
-//const int MAX_QUBITS = 20;
 int GLOBALCOUNTER=0;
 
-Node::Node() {
-	for(int x = 0; x < MAX_QUBITS; x++) {
+vector<GateNode*> GateNode::gates;
+SlabPool Node::pool(sizeof(Node));
+int Node::numQubits = 0;
+int Node::width = 0;
+std::size_t Node::storageSize = 0;
+
+void Node::setNumQubits(int numPhysicalQubits) {
+	assert(numPhysicalQubits > 0 && numPhysicalQubits <= MAX_QUBITS);
+	numQubits = numPhysicalQubits;
+	width = 0;
+	for(int x = 0; x < NUM_NODE_WIDTHS; x++) {
+		if(numPhysicalQubits <= NODE_WIDTHS[x]) {
+			width = NODE_WIDTHS[x];
+			break;
+		}
+	}
+	
+	//the per-qubit arrays follow the node, widest elements first so each stays aligned
+	storageSize = 2 * numQubits * sizeof(ScheduledGate*);
+	storageSize += 2 * numQubits * sizeof(unsigned int);
+	storageSize += 2 * numQubits * sizeof(qubit_t);
+	pool.setObjectSize(sizeof(Node) + storageSize);
+}
+
+Node::Node(Uninitialized) {
+	char * storage = this->storage();
+	lastNonSwapGate = (ScheduledGate**) storage;
+	storage += numQubits * sizeof(ScheduledGate*);
+	lastGate = (ScheduledGate**) storage;
+	storage += numQubits * sizeof(ScheduledGate*);
+	readyGates.setStorage((unsigned int*) storage, numQubits);
+	storage += numQubits * sizeof(unsigned int);
+	lastTwoQubitGate = (unsigned int*) storage;
+	storage += numQubits * sizeof(unsigned int);
+	qal = (qubit_t*) storage;
+	storage += numQubits * sizeof(qubit_t);
+	laq = (qubit_t*) storage;
+}
+
+Node::Node() : Node(Uninitialized()) {
+	for(int x = 0; x < numQubits; x++) {
 		qal[x] = x;
 		laq[x] = x;
 		lastNonSwapGate[x] = NULL;
 		lastGate[x] = NULL;
+		lastTwoQubitGate[x] = 0;
 	}
 	this->cost = 0;
 	this->dead = false;
+	rehash();
+}
+
+void Node::rehash() {
+	mappingHash = 0;
+	for(int x = 0; x < numQubits; x++) {
+		if(qal[x] >= 0) {
+			mappingHash ^= qubitKey(x, qal[x]);
+		}
+	}
+	readyHash = 0;
+	for(GateNode * g : readyGates) {
+		readyHash ^= gateKey(g->id);
+	}
 }
 	
 Node::~Node() {
-	scheduled->clean();
+	//if no other node's schedule goes through our last entry, the entries only we used can be reused right away
+	env->schedule->release(scheduled);
+}
+
+//add child to ready gates if its parents other than gate have already been scheduled
+void Node::addReadyChild(GateNode * gate, GateNode * child) {
+	if(child->numParents == 1) {
+		if(readyGates.insert(child)) {
+			readyHash ^= gateKey(child->id);
+		}
+		return;
+	}
+	
+	int otherParentBit;
+	GateNode * otherParent;
+	if(child->controlParent == gate) {
+		otherParent = child->targetParent;
+		otherParentBit = child->target;
+	} else {
+		assert(child->targetParent == gate);
+		otherParent = child->controlParent;
+		otherParentBit = child->control;
+	}
+	if(this->lastNonSwapGate[otherParentBit] && this->lastNonSwapGate[otherParentBit]->gate() == otherParent) {
+		if(readyGates.insert(child)) {
+			readyHash ^= gateKey(child->id);
+		}
+	}
 }
 
 //schedule a gate, or return false if it conflicts with an active gate
@@ -27,8 +109,7 @@ Node::~Node() {
 //the timeOffset can be used if we want to schedule a gate to start X cycles in the future
 //this function adjusts qubit map when scheduling a swap
 bool Node::scheduleGate(GateNode * gate, unsigned int timeOffset) {
-	bool isSwap = !gate->name.compare("swp");
-	isSwap = isSwap || !gate->name.compare("swp");
+	bool isSwap = gate->isSwap;
 	
 	int physicalControl = gate->control;
 	int physicalTarget = gate->target;
@@ -51,101 +132,57 @@ bool Node::scheduleGate(GateNode * gate, unsigned int timeOffset) {
 	}
 	
 	if(!isSwap) {
-		//if appropriate, add double-child to ready gates
-		if(gate->controlChild && gate->controlChild == gate->targetChild) {
-			readyGates.insert(gate->controlChild);
+		if(gate->controlChild) {
+			addReadyChild(gate, gate->controlChild);
 		}
-		//if appropriate, add control child to ready gates
-		if(gate->controlChild && gate->controlChild != gate->targetChild) {
-			if(gate->controlChild->control < 0) {//single-qubit gate
-				readyGates.insert(gate->controlChild);
-			} else {
-				int childParentBit;
-				GateNode * otherParent;
-				if(gate->controlChild->controlParent == gate) {
-					otherParent = gate->controlChild->targetParent;
-					if(gate->controlChild->targetParent) {
-						childParentBit = gate->controlChild->target;
-					} else {
-						childParentBit = -1;
-					}
-				} else {
-					assert(gate->controlChild->targetParent == gate);
-					otherParent = gate->controlChild->controlParent;
-					if(gate->controlChild->controlParent) {
-						childParentBit = gate->controlChild->control;
-					} else {
-						childParentBit = -1;
-					}
-				}
-				if(childParentBit < 0 || (this->lastNonSwapGate[childParentBit] && this->lastNonSwapGate[childParentBit]->gate == otherParent)) {
-					readyGates.insert(gate->controlChild);
-				}
-			}
-		}
-		//if appropriate, add target child to ready gates
-		if(gate->targetChild && gate->controlChild != gate->targetChild) {
-			if(gate->targetChild->control < 0) {//single-qubit gate
-				readyGates.insert(gate->targetChild);
-			} else {
-				int childParentBit;
-				GateNode * otherParent;
-				if(gate->targetChild->controlParent == gate) {
-					otherParent = gate->targetChild->targetParent;
-					if(gate->targetChild->targetParent) {
-						childParentBit = gate->targetChild->target;
-					} else {
-						childParentBit = -1;
-					}
-				} else {
-					assert(gate->targetChild->targetParent == gate);
-					otherParent = gate->targetChild->controlParent;
-					if(gate->targetChild->controlParent) {
-						childParentBit = gate->targetChild->control;
-					} else {
-						childParentBit = -1;
-					}
-				}
-				if(childParentBit < 0 || (this->lastNonSwapGate[childParentBit] && this->lastNonSwapGate[childParentBit]->gate == otherParent)) {
-					readyGates.insert(gate->targetChild);
-				}
-			}
+		if(gate->targetChild && gate->targetChild != gate->controlChild) {
+			addReadyChild(gate, gate->targetChild);
 		}
 	}
 	
-	ScheduledGate * sg = new ScheduledGate(gate, this->cycle + timeOffset);
+	unsigned int index = env->schedule->append(this->scheduled);
+	ScheduledGate * sg = env->schedule->get(index);
+	sg->gateID = gate->id;
+	sg->cycle = this->cycle + timeOffset;
 	sg->physicalControl = physicalControl;
 	sg->physicalTarget = physicalTarget;
-	sg->latency = env->latency->getLatency(sg->gate->name, (sg->physicalControl >= 0 ? 2 : 1), sg->physicalTarget, sg->physicalControl);
+	int latency = env->latency->getLatency(gate->type, (physicalControl >= 0 ? 2 : 1), physicalTarget, physicalControl);
+	assert(latency <= SHRT_MAX);
+	sg->latency = latency;
 	
 	if(physicalControl >= 0) {
 		this->lastGate[physicalControl] = sg;
+		this->lastTwoQubitGate[physicalControl] = index;
+		this->lastTwoQubitGate[physicalTarget] = index;
 	}
-	if(sg->gate->control >= 0 && !isSwap) {
-		this->lastNonSwapGate[sg->gate->control] = sg;
+	if(gate->control >= 0 && !isSwap) {
+		this->lastNonSwapGate[gate->control] = sg;
 	}
 		
 	if(physicalTarget >= 0) {
 		this->lastGate[physicalTarget] = sg;
 	}
-	if(sg->gate->target >= 0 && !isSwap) {
-		this->lastNonSwapGate[sg->gate->target] = sg;
+	if(gate->target >= 0 && !isSwap) {
+		this->lastNonSwapGate[gate->target] = sg;
 	}
 	
 	if(!isSwap) {
 		if(this->readyGates.erase(gate) != 1) {
 			std::cerr << "FATAL ERROR: unable to remove scheduled gate from ready list.\n";
-			std::cerr << "\tGate name: " << gate->name << "\n";
+			std::cerr << "\tGate name: " << gate->name() << "\n";
 			std::cerr << "\tTime offset: " << timeOffset << "\n";
 			assert(false);
 		}
+		this->readyHash ^= gateKey(gate->id);
 		this->numUnscheduledGates--;
 	}
 	
-	this->scheduled = this->scheduled->push(sg);
+	this->scheduled = index;
+	this->numScheduled++;
 	
 	//adjust qubit map
 	if(isSwap) {
+		moveHash(physicalControl, physicalTarget);
 		if(qal[physicalControl] >= 0 && qal[physicalTarget] >= 0) {
 			std::swap(laq[(int)qal[physicalControl]], laq[(int)qal[physicalTarget]]);
 		} else if(qal[physicalControl] >= 0) {
@@ -163,20 +200,30 @@ bool Node::scheduleGate(GateNode * gate, unsigned int timeOffset) {
 	
 //prepares a new child node (without scheduling any more gates)
 Node * Node::prepChild() {
-	Node * child = new Node;
-	child->numUnscheduledGates = this->numUnscheduledGates;
-	child->env = this->env;
+	Node * child = this->prepSibling();
 	child->parent = this;
 	child->cycle = this->cycle + 1;
-	child->readyGates = this->readyGates;//note: this actually produces a separate copy
-	child->scheduled = scheduled->newRef();
-	for(int x = 0; x < env->numPhysicalQubits; x++) {
-		child->qal[x] = this->qal[x];
-		child->laq[x] = this->laq[x];
-		child->lastNonSwapGate[x] = this->lastNonSwapGate[x];
-		child->lastGate[x] = this->lastGate[x];
-	}
-	child->cost = 0;//Remember to calculate cost in expander, *after* it's done scheduling new gates for this node //child->cost = env->cost->getCost(child);
 	
 	return child;
 }
+
+//prepares a copy of this node (which must not be in the queue yet), so more gates can be scheduled on the copy
+Node * Node::prepSibling() {
+	Node * sibling = new Node(Uninitialized());
+	sibling->numUnscheduledGates = this->numUnscheduledGates;
+	sibling->env = this->env;
+	sibling->parent = this->parent;
+	sibling->cycle = this->cycle;
+	sibling->scheduled = this->scheduled;
+	env->schedule->acquire(this->scheduled);
+	sibling->numScheduled = this->numScheduled;
+	sibling->mappingHash = this->mappingHash;
+	sibling->readyHash = this->readyHash;
+	
+	std::memcpy(sibling->storage(), this->storage(), storageSize);
+	sibling->readyGates.setSize(this->readyGates.size());
+	
+	sibling->cost = 0;//Remember to calculate cost in expander, *after* it's done scheduling new gates for this node //child->cost = env->cost->getCost(child);
+	
+	return sibling;
+}
@@ -3,16 +3,36 @@
 
 #include "Environment.hpp"
 #include "GateNode.hpp"
-#include "LinkedStack.hpp"
+#include "GateSet.hpp"
 #include "ScheduledGate.hpp"
-#include <set>
+#include "ScheduleLog.hpp"
+#include "SlabPool.hpp"
 #include <cassert>
+#include <climits>
+#include <cstdint>
 #include <iostream>
 class Queue;
 using namespace std;
 
-//Warning: you may need to run make clean after changing MAX_QUBITS
-const int MAX_QUBITS = 20;
+typedef short qubit_t;//a qubit index, or -1 for none
+const int MAX_QUBITS = SHRT_MAX;//largest number of physical qubits a qubit_t (and a ScheduledGate) can address
+
+//Device widths the search core is compiled for; see Node::width.
+//Devices wider than the largest one use the generic code (instantiated with width 0).
+const int NUM_NODE_WIDTHS = 5;
+const int NODE_WIDTHS[NUM_NODE_WIDTHS] = {8, 16, 32, 64, 128};
+
+//Evaluates "return func<W> args;" for the width W that Node::setNumQubits picked at startup.
+//Inside func, per-qubit scratch arrays can be sized "W ? W : Node::numQubits", which is a compile-time constant when W > 0.
+#define DISPATCH_NODE_WIDTH(func, args) \
+	switch(Node::width) { \
+		case 8: return func<8> args; \
+		case 16: return func<16> args; \
+		case 32: return func<32> args; \
+		case 64: return func<64> args; \
+		case 128: return func<128> args; \
+		default: return func<0> args; \
+	}
 //extern int GLOBALCOUNTER;
 
 class Node {
@@ -26,14 +46,22 @@ class Node {
 	int numUnscheduledGates;//the number of gates from the original circuit that are not yet part of this node's schedule
 	bool expanded = false;//whether or not this node has been popped from the queue
 	bool dead = false;//where or not this node has been marked as 'dead' by a filter
+	bool requeued = false;//whether or not a memory-bounded queue has pushed this node again after it was expanded
+	
+	//only tracked by memory-bounded queues:
+	int numChildren = 0;//number of this node's children that are still in memory
+	int forgottenCost = INT_MAX;//lowest cost among children dropped since this node was last queued
 	
 	//int debugID = GLOBALCOUNTER++;
 	
-	char qal[MAX_QUBITS];//qubit mapping
-	char laq[MAX_QUBITS];//qubit mapping (inverted)
+	//The per-qubit arrays below have numQubits entries each.
+	//They're stored inline, in the same pool allocation right after the node's fields.
+	qubit_t * qal;//qubit mapping
+	qubit_t * laq;//qubit mapping (inverted)
 	
-	ScheduledGate * lastNonSwapGate[MAX_QUBITS];//last scheduled non-swap gate per LOGICAL qubit
-	ScheduledGate * lastGate[MAX_QUBITS];//last scheduled gate per PHYSICAL qubit
+	ScheduledGate ** lastNonSwapGate;//last scheduled non-swap gate per LOGICAL qubit
+	ScheduledGate ** lastGate;//last scheduled gate per PHYSICAL qubit
+	unsigned int * lastTwoQubitGate;//log index of the last scheduled two-qubit gate (swaps included) per PHYSICAL qubit, or 0 if none
 	
 	//the number of cycles until the specified physical qubit is available
 	inline int busyCycles(int physicalQubit) {
@@ -44,19 +72,81 @@ class Node {
 		return cycles;
 	}
 	
-	std::set<GateNode*> readyGates;//set of gates in DAG whose parents have already been scheduled
+	GateSet readyGates;//set of gates in DAG whose parents have already been scheduled
 	
-	LinkedStack<ScheduledGate*> * scheduled;//list of scheduled gates. Warning: this linked list's data overlaps with the same list in parent node
+	//Zobrist-style hashes of the node's state, updated in O(1) as qubits move and gates become ready or get scheduled.
+	//Code that writes to qal/laq/readyGates directly (instead of through the functions below) must call rehash afterwards.
+	uint64_t mappingHash = 0;//XOR of qubitKey(p, qal[p]) over every physical qubit p holding a logical qubit
+	uint64_t readyHash = 0;//XOR of gateKey(g->id) over every ready gate g
+	
+	//hash of the qubit mapping and the ready gates
+	inline uint64_t stateHash() const {
+		return mappingHash ^ readyHash;
+	}
+	
+	static inline uint64_t mix64(uint64_t x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+	
+	//pseudorandom key for a logical qubit sitting on a physical qubit
+	static inline uint64_t qubitKey(int physical, int logical) {
+		return mix64(((uint64_t) physical << 32) | (uint32_t) logical);
+	}
+	
+	//pseudorandom key for a ready gate (distinct from every qubit key's input, since physical qubits are < 2^15)
+	static inline uint64_t gateKey(unsigned int id) {
+		return mix64((1ULL << 63) | id);
+	}
+	
+	///Recompute mappingHash and readyHash from scratch
+	void rehash();
+	
+	unsigned int scheduled;//log index of the last scheduled gate, or 0 if none; the node holds a reference to it. Warning: this schedule's entries overlap with the parent node's schedule
+	int numScheduled;//number of gates in this node's schedule
 	
 	Node();
 	
 	~Node();
 	
+	//length of every node's per-qubit arrays; set once (by setNumQubits) before the first node is created
+	static int numQubits;
+	
+	//smallest entry of NODE_WIDTHS that fits numQubits, or 0 if none does
+	static int width;
+	
+	///Size all nodes for a device with the specified number of physical qubits
+	static void setNumQubits(int numPhysicalQubits);
+	
+	//bytes of per-qubit storage following each node
+	static std::size_t storageSize;
+	
+	inline char * storage() {
+		return (char*) (this + 1);
+	}
+	
+	//nodes come from a slab pool instead of the general-purpose heap, since we create and delete so many of them
+	static SlabPool pool;
+	static void * operator new(std::size_t size) {
+		assert(size == sizeof(Node));
+		assert(numQubits > 0);
+		return pool.allocate();
+	}
+	static void operator delete(void * p) {
+		if(p) pool.deallocate(p);
+	}
+	
 	//swap two physical qubits in qubit map, without scheduling a gate
 	inline bool swapQubits(int physicalControl, int physicalTarget) {
 		if(qal[physicalControl] < 0 && qal[physicalTarget] < 0) {
 			return false;
-		} else if(qal[physicalTarget] < 0) {
+		}
+		moveHash(physicalControl, physicalTarget);
+		if(qal[physicalTarget] < 0) {
 			laq[(int)qal[physicalControl]] = physicalTarget;
 		} else if(qal[physicalControl] < 0) {
 			laq[(int)qal[physicalTarget]] = physicalControl;
@@ -67,14 +157,44 @@ class Node {
 		return true;
 	}
 	
+	//place a logical qubit on an empty physical qubit, without scheduling a gate
+	inline void mapQubit(int logical, int physical) {
+		assert(laq[logical] < 0 && qal[physical] < 0);
+		laq[logical] = physical;
+		qal[physical] = logical;
+		mappingHash ^= qubitKey(physical, logical);
+	}
+	
 	//schedule a gate, or return false if it conflicts with an active gate
 	//the gate parameter uses logical qubits (except in swaps); this function determines physical locations based on prior swaps
 	//the timeOffset can be used if we want to schedule a gate to start X cycles in the future
 	//this function adjusts qubit map when scheduling a swap
 	bool scheduleGate(GateNode * gate, unsigned int timeOffset = 0);
 	
+	//add child to ready gates if its parents other than gate have already been scheduled
+	void addReadyChild(GateNode * gate, GateNode * child);
+	
 	//prepares a new child node (without scheduling any more gates)
 	Node * prepChild();
+	
+	//prepares a copy of this node (which must not be in the queue yet), so more gates can be scheduled on the copy
+	Node * prepSibling();
+	
+  private:
+	struct Uninitialized {};
+	
+	//update mappingHash for swapping the contents of two physical qubits (call it before changing qal)
+	inline void moveHash(int a, int b) {
+		if(qal[a] >= 0) {
+			mappingHash ^= qubitKey(a, qal[a]) ^ qubitKey(b, qal[a]);
+		}
+		if(qal[b] >= 0) {
+			mappingHash ^= qubitKey(b, qal[b]) ^ qubitKey(a, qal[b]);
+		}
+	}
+	
+	//sets up the per-qubit arrays without filling them in; prepChild copies them from the parent instead
+	Node(Uninitialized);
 };
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef QUBITMASK_HPP
+#define QUBITMASK_HPP
+
+using namespace std;
+
+/**
+ * A set of physical qubits, stored as a fixed-size bitmask.
+ * W is one of the NODE_WIDTHS (see Node.hpp), so a mask for a small device is a single register.
+ * There's no mask for width 0 (devices wider than every NODE_WIDTHS entry); callers fall back to something else.
+ */
+template <int W>
+class QubitMask {
+  private:
+	static const int WORDS = (W + 63) / 64;
+	unsigned long long words[WORDS];
+
+  public:
+	QubitMask() {
+		clear();
+	}
+	
+	inline void clear() {
+		for(int x = 0; x < WORDS; x++) {
+			words[x] = 0;
+		}
+	}
+	
+	///Add the specified qubit; negative qubits (i.e. no qubit) are ignored
+	inline void add(int qubit) {
+		if(qubit >= 0) {
+			words[qubit >> 6] |= 1ULL << (qubit & 63);
+		}
+	}
+	
+	inline bool overlaps(const QubitMask<W> & other) const {
+		unsigned long long shared = 0;
+		for(int x = 0; x < WORDS; x++) {
+			shared |= words[x] & other.words[x];
+		}
+		return shared != 0;
+	}
+	
+	inline QubitMask<W> & operator|=(const QubitMask<W> & other) {
+		for(int x = 0; x < WORDS; x++) {
+			words[x] |= other.words[x];
+		}
+		return *this;
+	}
+};
+
+#endif
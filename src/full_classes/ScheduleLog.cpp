@@ -0,0 +1,81 @@
+#include "ScheduleLog.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+using namespace std;
+
+thread_local ScheduleLog::Cursor ScheduleLog::cursor;
+
+ScheduleLog::ScheduleLog() : numLive(0) {
+	this->chunks = new ScheduledGate*[MAX_CHUNKS];
+}
+
+ScheduleLog::~ScheduleLog() {
+	clear();
+	delete [] this->chunks;
+}
+
+//Called when this thread has no room left in its block: hand it the next unused block
+void ScheduleLog::reserveBlock() {
+	std::lock_guard<std::mutex> lock(reserveLock);
+	
+	if(reserved + BLOCK_SIZE < reserved) {
+		std::cerr << "FATAL ERROR: schedule log ran out of indices.\n";
+		assert(false);
+		exit(1);
+	}
+	
+	//blocks never straddle two chunks, so a new chunk is only needed at the start of a block:
+	if((reserved >> CHUNK_BITS) >= numChunks) {
+		chunks[numChunks++] = new ScheduledGate[CHUNK_SIZE];
+	}
+	
+	if(!hasCursor()) {
+		//entries on the free list came from a log (or generation) that's gone:
+		cursor.freed.clear();
+	}
+	cursor.log = this;
+	cursor.generation = generation;
+	cursor.next = reserved ? reserved : 1;//skip index 0, since it means 'empty schedule'
+	cursor.blockEnd = reserved + BLOCK_SIZE;
+	reserved += BLOCK_SIZE;
+}
+
+void ScheduleLog::release(unsigned int index) {
+	while(index) {
+		ScheduledGate * sg = get(index);
+		unsigned short r = sg->refs.load(std::memory_order_relaxed);
+		do {
+			if(r == ScheduledGate::STUCK) {
+				return;
+			}
+		} while(!sg->refs.compare_exchange_weak(r, r - 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+		if(r != 1) {
+			return;
+		}
+		
+		//that was the last reference, so the entry is ours to reuse, and it no longer keeps its parent alive:
+		if(!hasCursor()) {
+			cursor.freed.clear();
+			cursor.log = this;
+			cursor.generation = generation;
+			cursor.next = cursor.blockEnd = 0;
+		}
+		cursor.freed.push_back(index);
+		numLive.fetch_sub(1, std::memory_order_relaxed);
+		index = sg->parent;
+	}
+}
+
+void ScheduleLog::clear() {
+	std::lock_guard<std::mutex> lock(reserveLock);
+	for(unsigned int x = 0; x < numChunks; x++) {
+		delete [] chunks[x];
+	}
+	numChunks = 0;
+	reserved = 0;
+	numLive = 0;
+	
+	//every thread's block is gone; bumping the generation makes them reserve new ones
+	generation++;
+}
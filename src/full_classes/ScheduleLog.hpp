@@ -0,0 +1,115 @@
+#ifndef SCHEDULELOG_HPP
+#define SCHEDULELOG_HPP
+
+#include "ScheduledGate.hpp"
+#include <atomic>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+/**
+ * Storage for the scheduled gates of every node in the search.
+ * Each entry names the previously scheduled gate of its schedule by log index, so the log is a tree of schedules:
+	a node's schedule is just the index of its last entry, and a child extends its parent's schedule by appending.
+ * Entries live in large fixed chunks, so pointers to them stay valid for as long as the entry is referenced.
+ * Each entry counts its references: nodes whose schedule ends there, and entries that follow it.
+	When the last one goes away, the entry goes on the releasing thread's free list, and its parent loses a reference.
+	The count is 16 bits to keep entries at 20 bytes; an entry that ever reaches ScheduledGate::STUCK references
+	(e.g. the last gate of a node with that many subset children) simply stays live until clear().
+	So the log holds the schedules of the live nodes, not every gate scheduled over the whole search;
+	its chunks only grow to the most entries that were ever live at once, and are freed by clear().
+ * Each thread appends into its own block of indices (and its own free list),
+	so the parallel search doesn't need to lock on every append.
+ * Index 0 is never used; it stands for the empty schedule.
+ */
+class ScheduleLog {
+  private:
+	static const int CHUNK_BITS = 16;
+	static const unsigned int CHUNK_SIZE = 1u << CHUNK_BITS;//entries per chunk
+	static const unsigned int MAX_CHUNKS = 1u << (32 - CHUNK_BITS);
+	static const unsigned int BLOCK_SIZE = 1024;//entries a thread reserves at a time; CHUNK_SIZE must be a multiple of this
+	
+	//the block of indices the current thread is appending into:
+	struct Cursor {
+		const ScheduleLog * log;
+		unsigned int generation;
+		unsigned int next;
+		unsigned int blockEnd;
+		std::vector<unsigned int> freed;//entries this thread released, to reuse before the block
+	};
+	static thread_local Cursor cursor;
+	
+	ScheduledGate ** chunks;
+	unsigned int numChunks = 0;
+	unsigned int reserved = 0;//first index not yet handed to any thread
+	unsigned int generation = 1;
+	std::mutex reserveLock;
+	std::atomic<long> numLive;//entries with references
+	
+	void reserveBlock();
+	
+	inline bool hasCursor() {
+		return cursor.log == this && cursor.generation == generation;
+	}
+
+  public:
+	ScheduleLog();
+	~ScheduleLog();
+	
+	inline ScheduledGate * get(unsigned int index) {
+		return &chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+	}
+	
+	///Add an entry following the specified entry; returns the new entry's index
+	///The caller's reference to parent passes to the new entry, and the caller holds the only reference to the new entry
+	inline unsigned int append(unsigned int parent) {
+		unsigned int index;
+		if(hasCursor() && !cursor.freed.empty()) {
+			index = cursor.freed.back();
+			cursor.freed.pop_back();
+		} else {
+			if(!hasCursor() || cursor.next == cursor.blockEnd) {
+				reserveBlock();
+			}
+			index = cursor.next++;
+		}
+		ScheduledGate * sg = get(index);
+		sg->parent = parent;
+		sg->refs.store(1, std::memory_order_relaxed);
+		numLive.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+	
+	///Add a reference to the specified entry (if any), for a node that shares the schedule ending there
+	inline void acquire(unsigned int index) {
+		if(index) {
+			std::atomic<unsigned short> & refs = get(index)->refs;
+			unsigned short r = refs.load(std::memory_order_relaxed);
+			while(r != ScheduledGate::STUCK && !refs.compare_exchange_weak(r, r + 1, std::memory_order_relaxed)) {
+			}
+		}
+	}
+	
+	///Drop a reference to the specified entry (if any); entries left without references are reused by later appends
+	void release(unsigned int index);
+	
+	///Free every entry at once; all nodes must be dead by now
+	void clear();
+	
+	///Number of log indices handed out so far
+	inline unsigned int size() {
+		return reserved;
+	}
+	
+	///Number of bytes held in chunks
+	inline std::size_t getBytesReserved() {
+		return (std::size_t) numChunks * CHUNK_SIZE * sizeof(ScheduledGate);
+	}
+	
+	///Number of entries some node's schedule still uses
+	inline long getNumLive() {
+		return numLive.load(std::memory_order_relaxed);
+	}
+};
+
+#endif
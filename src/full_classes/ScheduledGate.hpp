@@ -2,24 +2,29 @@
 #define SCHEDULEDGATE_HPP
 
 #include "GateNode.hpp"
+#include <atomic>
+#include <climits>
 using namespace std;
 
+//An entry in the schedule log; kept small since the search creates so many of these
 class ScheduledGate {
   public:
-	GateNode * gate;
+	unsigned int gateID;//the scheduled gate's id (see GateNode::gates)
+	unsigned int parent;//log index of the gate scheduled just before this one, or 0 if this is the first
 	int cycle;//cycle when this gate started
-	int physicalControl;
-	int physicalTarget;
+	std::atomic<unsigned short> refs;//number of nodes whose schedule ends here, plus number of entries whose parent this is; see STUCK
+	short latency;
+	short physicalControl;
+	short physicalTarget;
 	
-	int latency;
+	///refs never moves once it reaches this; the entry then stays live until ScheduleLog::clear()
+	static const unsigned short STUCK = USHRT_MAX;
 	
-	ScheduledGate(GateNode * gate, int cycle) {
-		this->gate = gate;
-		this->cycle = cycle;
-		this->physicalControl = -1;
-		this->physicalTarget = -1;
-		this->latency = 99999999;
+	inline GateNode * gate() const {
+		return GateNode::gates[gateID];
 	}
 };
 
+static_assert(sizeof(ScheduledGate) <= 20, "schedule log entries should stay at 20 bytes");
+
 #endif
@@ -0,0 +1,101 @@
+#include "SlabPool.hpp"
+#include <cassert>
+#include <cstdlib>
+#ifdef LINUX
+#include <sys/mman.h>
+#endif
+using namespace std;
+
+thread_local SlabPool::ThreadCache SlabPool::caches[SlabPool::MAXPOOLS];
+int SlabPool::numPools = 0;
+bool SlabPool::useHugePages = false;
+
+const std::size_t SLAB_SIZE = 1 << 20;
+const std::size_t HUGE_SLAB_SIZE = 1 << 21;//matches the 2MB huge page size on x86-64
+
+SlabPool::SlabPool(std::size_t objectSize) {
+	//pools are only created during static initialization, so this doesn't need to be thread-safe:
+	assert(numPools < MAXPOOLS);
+	this->id = numPools++;
+	this->slabSize = 0;
+	setObjectSize(objectSize);
+}
+
+void SlabPool::setObjectSize(std::size_t objectSize) {
+	//objects already handed out would be the wrong size:
+	assert(slabs.empty());
+	
+	//keep objects pointer-aligned, and big enough to hold a free list link
+	if(objectSize < sizeof(FreeBlock)) {
+		objectSize = sizeof(FreeBlock);
+	}
+	this->objectSize = (objectSize + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+	this->slabSize = 0;
+}
+
+SlabPool::~SlabPool() {
+	release();
+}
+
+void * SlabPool::newSlab(std::size_t size) {
+	void * slab = 0;
+	if(useHugePages) {
+#ifdef LINUX
+		if(posix_memalign(&slab, HUGE_SLAB_SIZE, size)) {
+			slab = 0;
+		} else {
+			madvise(slab, size, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	if(!slab) {
+		slab = std::malloc(size);
+	}
+	assert(slab);
+	return slab;
+}
+
+void SlabPool::freeSlab(void * slab, std::size_t size) {
+	std::free(slab);
+}
+
+//Called when this thread's cache has no free objects left: give the thread a fresh slab
+void * SlabPool::allocateSlow() {
+	ThreadCache & c = caches[id];
+	if(c.generation != generation) {
+		c.freeList = 0;
+		c.bump = c.bumpEnd = 0;
+		c.generation = generation;
+	}
+	
+	{
+		std::lock_guard<std::mutex> lock(slabLock);
+		if(!slabSize) {
+			slabSize = useHugePages ? HUGE_SLAB_SIZE : SLAB_SIZE;
+			while(slabSize < objectSize * 16) {
+				slabSize *= 2;
+			}
+		}
+		char * slab = (char*) newSlab(slabSize);
+		slabs.push_back(std::make_pair((void*) slab, slabSize));
+		bytesReserved += slabSize;
+		c.bump = slab;
+		c.bumpEnd = slab + (slabSize / objectSize) * objectSize;
+	}
+	
+	void * ret = c.bump;
+	c.bump += objectSize;
+	return ret;
+}
+
+void SlabPool::release() {
+	std::lock_guard<std::mutex> lock(slabLock);
+	for(unsigned int x = 0; x < slabs.size(); x++) {
+		freeSlab(slabs[x].first, slabs[x].second);
+	}
+	slabs.clear();
+	bytesReserved = 0;
+	
+	//every thread's cache now points into freed memory; bumping the generation makes them start over
+	generation++;
+}
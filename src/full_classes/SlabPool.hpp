@@ -0,0 +1,94 @@
+#ifndef SLABPOOL_HPP
+#define SLABPOOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+/**
+ * A fixed-size object allocator for the objects the search creates and deletes by the million.
+ * Memory is carved out of large slabs; freed objects go onto a per-thread free list and get reused.
+ * Slabs are only returned to the system by release() (or when the pool is destroyed).
+ * Objects may be freed by a different thread than the one that allocated them.
+ */
+class SlabPool {
+  private:
+	struct FreeBlock {
+		FreeBlock * next;
+	};
+	
+	//per-thread allocation state for one pool:
+	struct ThreadCache {
+		FreeBlock * freeList;
+		char * bump;//next unused object in this thread's current slab
+		char * bumpEnd;
+		unsigned int generation;//pool's generation when this cache was filled; stale caches are reset
+	};
+	
+	static const int MAXPOOLS = 8;
+	static thread_local ThreadCache caches[MAXPOOLS];
+	static int numPools;
+	
+	int id;//index into caches
+	std::size_t objectSize;
+	std::size_t slabSize;
+	unsigned int generation = 1;
+	
+	std::mutex slabLock;
+	std::vector<std::pair<void*, std::size_t> > slabs;
+	std::size_t bytesReserved = 0;
+	
+	void * allocateSlow();
+	void * newSlab(std::size_t size);
+	void freeSlab(void * slab, std::size_t size);
+
+  public:
+	///Back new slabs with transparent huge pages (where the OS supports it)
+	static bool useHugePages;
+	
+	SlabPool(std::size_t objectSize);
+	~SlabPool();
+	
+	inline void * allocate() {
+		ThreadCache & c = caches[id];
+		if(c.generation == generation) {
+			if(c.freeList) {
+				FreeBlock * b = c.freeList;
+				c.freeList = b->next;
+				return b;
+			}
+			if(c.bump != c.bumpEnd) {
+				void * ret = c.bump;
+				c.bump += objectSize;
+				return ret;
+			}
+		}
+		return allocateSlow();
+	}
+	
+	inline void deallocate(void * p) {
+		ThreadCache & c = caches[id];
+		if(c.generation != generation) {
+			c.freeList = 0;
+			c.bump = c.bumpEnd = 0;
+			c.generation = generation;
+		}
+		FreeBlock * b = (FreeBlock*) p;
+		b->next = c.freeList;
+		c.freeList = b;
+	}
+	
+	///Change the size of the objects this pool hands out; only allowed while the pool holds no slabs
+	void setObjectSize(std::size_t objectSize);
+	
+	///Return every slab to the system at once; all objects from this pool must be dead by now
+	void release();
+	
+	///Number of bytes currently held in slabs
+	std::size_t getBytesReserved() {
+		return bytesReserved;
+	}
+};
+
+#endif
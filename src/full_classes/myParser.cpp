@@ -1,5 +1,6 @@
 #include "myParser.hpp"
 #include "Environment.hpp"
+#include "GateType.hpp"
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -303,7 +304,7 @@ std::vector<ParsedGate> parse(Environment * env, const char * fileName) {
 		} else if(!strcmp(token, ";")) {
 			std::cerr << "Warning: unexpected semicolon.\n";
 		} else {
-			char * gateName = token;
+			int gateName = GateType::intern(token);
 			char * qubit1Token = getToken(infile, b);
 			if(strcmp(qubit1Token, ";")) {
 				assert(qubit1Token && qubit1Token[0] != 0);
@@ -6,7 +6,7 @@
 using namespace std;
 
 struct ParsedGate {
-	char * type;
+	int type;//see GateType
 	int target;
 	int control;
 };
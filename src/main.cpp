@@ -7,7 +7,14 @@
 #include "NodeMod/Meta.hpp"
 #include "Filter/Meta.hpp"
 #include "Queue/Meta.hpp"
+#include "HDAStar.hpp"
+#include "IDAStar.hpp"
+#include "GreedyCompleter.hpp"
 #include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -143,11 +150,12 @@ void buildDependencyGraph(string qasmFileName, Latency * lat, set<GateNode*> & f
 	}
 	for(unsigned int x = 0; x < gates.size(); x++) {
 		GateNode * v = new GateNode;
+		assert(v->id == x);//gate ids must be dense, starting from the circuit's first gate
 		v->control = gates.at(x).control;
 		v->target = gates.at(x).target;
-		v->name = gates.at(x).type;
+		v->setType(gates.at(x).type);
 		v->criticality = 0;
-		v->optimisticLatency = lat->getLatency(v->name, (v->control >= 0 ? 2 : 1), -1, -1);
+		v->optimisticLatency = lat->getLatency(v->type, (v->control >= 0 ? 2 : 1), -1, -1);
 		v->controlChild = 0;
 		v->targetChild = 0;
 		v->controlParent = 0;
@@ -195,8 +203,10 @@ void buildDependencyGraph(string qasmFileName, Latency * lat, set<GateNode*> & f
 			lastGatePerQubit[v->target] = v;
 		}
 		
+		v->numParents = (v->controlParent ? 1 : 0) + ((v->targetParent && v->targetParent != v->controlParent) ? 1 : 0);
+		
 		//if v is a root gate, add it to firstGates
-		if(!v->controlParent && !v->targetParent) {
+		if(!v->numParents) {
 			firstGates.insert(v);
 		}
 	}
@@ -207,6 +217,22 @@ void buildDependencyGraph(string qasmFileName, Latency * lat, set<GateNode*> & f
 	idealCycles = setCriticality(lastGatePerQubit, numQubits);
 	
 	delete [] lastGatePerQubit;
+	
+	//sum up the 1-qubit gates between consecutive 2-qubit gates, so cost functions don't have to walk them
+	//children come later in the circuit (so they have higher ids) than their parents
+	for(int x = env->numGates - 1; x >= 0; x--) {
+		GateNode * v = GateNode::gates[x];
+		GateNode * child = v->targetChild;
+		if(child && child->control < 0) {
+			v->targetChainLatency = child->optimisticLatency + child->targetChainLatency;
+			assert(v->nextTargetCNOT == child->nextTargetCNOT);
+		}
+		child = v->controlChild;
+		if(v->control >= 0 && child && child->control < 0) {
+			v->controlChainLatency = child->optimisticLatency + child->targetChainLatency;
+			assert(v->nextControlCNOT == child->nextTargetCNOT);
+		}
+	}
 }
 
 //parse coupling map, producing a list of edges and number of physical qubits
@@ -225,41 +251,14 @@ void buildCouplingMap(string filename, set<pair<int, int> > & edges, int & numPh
 	}
 }
 
-//Calculate minimum distance between each pair of physical qubits
-//ToDo replace this with something more efficient?
-void calcDistances(int * distances, int numQubits) {
-	bool done = false;
-	while(!done) {
-		done = true;
-		for(int x = 0; x < numQubits; x++) {
-			for(int y = 0; y < numQubits; y++) {
-				if(x==y) {
-					continue;
-				}
-				for(int z = 0; z < numQubits; z++) {
-					if(x == z || y == z) {
-						continue;
-					}
-					
-					if(distances[x*numQubits + y] + distances[y*numQubits + z] < distances[x*numQubits + z]) {
-						done = false;
-						distances[x*numQubits + z] = distances[x*numQubits + y] + distances[y*numQubits + z];
-						distances[z*numQubits + x] = distances[x*numQubits + z];
-					}
-				}
-			}
-		}
-	}
-}
-
 //Print a node's scheduled gates
 //returns how many cycles the node takes to complete all its gates
-int printNode(std::ostream & stream, LinkedStack<ScheduledGate*> * gates) {
+int printNode(std::ostream & stream, Node * node) {
 	int cycles = 0;
+	ScheduleLog * log = node->env->schedule;
 	std::stack<ScheduledGate*> gateStack;
-	while(gates->size > 0) {
-		gateStack.push(gates->value);
-		gates = gates->next;
+	for(unsigned int x = node->scheduled; x; x = log->get(x)->parent) {
+		gateStack.push(log->get(x));
 	}
 	
 	while(!gateStack.empty()) {
@@ -267,17 +266,17 @@ int printNode(std::ostream & stream, LinkedStack<ScheduledGate*> * gates) {
 		gateStack.pop();
 		int target = sg->physicalTarget;
 		int control = sg->physicalControl;
-		stream << sg->gate->name << " ";
+		stream << sg->gate()->name() << " ";
 		if(control >= 0) {
 			stream << "q[" << control << "],";
 		}
 		stream << "q[" << target << "]";
 		stream << ";";
 		stream << " //cycle: " << sg->cycle;
-		if(sg->gate->name.compare("swp") && sg->gate->name.compare("SWP")) {
-			int target = sg->gate->target;
-			int control = sg->gate->control;
-			stream << " //" << sg->gate->name << " ";
+		if(!GateType::isSwapName(sg->gate()->type)) {
+			int target = sg->gate()->target;
+			int control = sg->gate()->control;
+			stream << " //" << sg->gate()->name() << " ";
 			if(control >= 0) {
 				stream << "q[" << control << "],";
 			}
@@ -293,6 +292,121 @@ int printNode(std::ostream & stream, LinkedStack<ScheduledGate*> * gates) {
 	return cycles;
 }
 
+//Print a final node's schedule as an OPENQASM circuit, preceded by the initial mapping it implies
+//returns how many cycles the schedule takes
+int printSchedule(std::ostream & stream, Node * finalNode) {
+	//Figure out what the initial mapping must have been
+	Environment * env = finalNode->env;
+	ScheduleLog * log = env->schedule;
+	unsigned int sgIndex = finalNode->scheduled;
+	std::vector<ScheduledGate*> inferredGates;//gates whose qubit we fill in just for printing
+	qubit_t inferredQal[env->numPhysicalQubits];
+	qubit_t inferredLaq[env->numPhysicalQubits];
+	for(int x = 0; x < env->numPhysicalQubits; x++) {
+		inferredQal[x] = finalNode->qal[x];
+		inferredLaq[x] = finalNode->laq[x];
+	}
+	/*
+	std::cerr << "//Note: qubit mapping at end (location of each logical qubit): ";
+	for(int x = 0; x < env->numLogicalQubits; x++) {
+		std::cerr << (int)inferredLaq[x] << ", ";
+	}
+	std::cerr << "\n";
+	std::cerr << "//Note: qubit mapping at end (logical qubit at each location): ";
+	for(int x = 0; x < env->numPhysicalQubits; x++) {
+		std::cerr << (int)inferredQal[x] << ", ";
+	}
+	std::cerr << "\n";
+	*/
+	while(sgIndex) {
+		ScheduledGate * sg = log->get(sgIndex);
+		if(sg->gate()->control >= 0) {
+			if(GateType::isSwapName(sg->gate()->type)) {
+				
+				if(inferredQal[sg->physicalControl] >= 0 && inferredQal[sg->physicalTarget] >= 0) {
+					std::swap(inferredLaq[(int)inferredQal[sg->physicalControl]], inferredLaq[(int)inferredQal[sg->physicalTarget]]);
+				} else if(inferredQal[sg->physicalControl] >= 0) {
+					inferredLaq[(int)inferredQal[sg->physicalControl]] = sg->physicalTarget;
+				} else if(inferredQal[sg->physicalTarget] >= 0) {
+					inferredLaq[(int)inferredQal[sg->physicalTarget]] = sg->physicalControl;
+				}
+				
+				std::swap(inferredQal[sg->physicalTarget], inferredQal[sg->physicalControl]);
+			}
+		} else {
+			if(sg->physicalTarget < 0) {
+				sg->physicalTarget = inferredLaq[sg->gate()->target];
+				inferredGates.push_back(sg);
+			}
+			
+			//in case this qubit's assignment is arbitrary:
+			if(sg->physicalTarget < 0) {
+				for(int x = 0; x < env->numPhysicalQubits; x++) {
+					if(inferredQal[x] < 0) {
+						inferredQal[x] = sg->gate()->target;
+						inferredLaq[sg->gate()->target] = x;
+						sg->physicalTarget = x;
+						break;
+					}
+				}
+			}
+		}
+		sgIndex = sg->parent;
+	}
+	
+	//Print out the initial mapping:
+	stream << "//Note: initial mapping (logical qubit at each location): ";
+	for(int x = 0; x < env->numPhysicalQubits; x++) {
+		stream << (int)inferredQal[x] << ", ";
+	}
+	stream << "\n";
+	stream << "//Note: initial mapping (location of each logical qubit): ";
+	for(int x = 0; x < env->numLogicalQubits; x++) {
+		stream << (int)inferredLaq[x] << ", ";
+	}
+	stream << "\n";
+	
+	//Print the OPENQASM output:
+	stream << "OPENQASM " << env->QASM_version << ";\n";
+	for(unsigned int x = 0; x < env->includes.size(); x++) {
+		stream << "include " << env->includes[x] << ";\n";
+	}
+	for(unsigned int x = 0; x < env->customGates.size(); x++) {
+		stream << "gate " << env->customGates[x] << "\n";
+	}
+	for(unsigned int x = 0; x < env->opaqueGates.size(); x++) {
+		stream << "opaque " << env->opaqueGates[x] << "\n";
+	}
+	stream << "qreg q[" << env->numPhysicalQubits << "];\n";
+	stream << "creg c[" << env->numPhysicalQubits << "];\n";
+	int numCycles = printNode(stream, finalNode);
+	for(unsigned int x = 0; x < env->measures.size(); x++) {
+		stream << "measure q[" << (int) finalNode->laq[env->measures[x].first] << "] -> c[" << env->measures[x].second << "];\n";
+	}
+	
+	//other final nodes may share these log entries, and imply a different location for these qubits:
+	for(unsigned int x = 0; x < inferredGates.size(); x++) {
+		inferredGates[x]->physicalTarget = -1;
+	}
+	
+	return numCycles;
+}
+
+//Write a final node's schedule to the specified file
+//replaces the file all at once, so whoever reads it never sees half a schedule
+void writeSchedule(const char * fileName, Node * finalNode) {
+	string tempName = string(fileName) + ".tmp";
+	std::ofstream file(tempName.c_str());
+	int numCycles = printSchedule(file, finalNode);
+	file << "//" << numCycles << " depth of generated circuit\n";
+	file.close();
+	if(!file || std::rename(tempName.c_str(), fileName)) {
+		std::cerr << "WARNING: couldn't write schedule to " << fileName << ".\n";
+		return;
+	}
+	std::cerr << "//Note: wrote a schedule with depth " << numCycles << " to " << fileName << ".\n";
+}
+
 //string comparison
 int caseInsensitiveCompare(const char * c1, const char * c2) {
 	for(int x = 0;; x++) {
@@ -316,6 +430,29 @@ int caseInsensitiveCompare(const char * c1, string str) {
 	return caseInsensitiveCompare(c1, c2);
 }
 
+//parse a user-specified qubit mapping (a list of integers, with any non-numeric separators)
+void parseMapping(const char * str, vector<int> & mapping) {
+	mapping.clear();
+	while(*str) {
+		if((*str < '0' || *str > '9') && *str != '-') {
+			str++;
+			continue;
+		}
+		char * end;
+		long val = strtol(str, &end, 10);
+		if(end == str) {
+			str++;
+			continue;
+		}
+		if(val < -1 || val >= MAX_QUBITS) {
+			std::cerr << "FATAL ERROR: qubit index " << val << " in specified mapping is out of range.\n";
+			exit(1);
+		}
+		mapping.push_back((int) val);
+		str = end;
+	}
+}
+
 int main(int argc, char** argv) {
 	char * qasmFileName = NULL;
 	char * couplingMapFileName = NULL;
@@ -327,6 +464,12 @@ int main(int argc, char** argv) {
 	Environment * env = new Environment;
 	
 	unsigned int retainPopped = 0;
+	int numThreads = 1;
+	bool weightedDistances = false;
+	char * anytimeFileName = NULL;//if set, we keep the best schedule found so far in this file
+	double timeLimit = 0;//if set, max number of seconds to search before finishing the schedule greedily
+	long nodeLimit = 0;//if set, max number of nodes to expand before finishing the schedule greedily
+	long idaTableSize = 0;//if set, we search with IDA* instead, using a transposition table with this many entries
 	
 	int choice = -1;
 	//bool printNumQubitsAndQuit = false;
@@ -335,48 +478,40 @@ int main(int argc, char** argv) {
 	int initialSearchCycles = 0;
 	
 	//variables for user-specified initial mapping:
-	char init_qal[MAX_QUBITS];
-	char init_laq[MAX_QUBITS];
+	vector<int> init_qal;
+	vector<int> init_laq;
 	int use_specified_init_mapping = 0;
 	
 	//Parse command-line arguments:
 	for(int iter = 1; iter < argc; iter++) {
 		if(!caseInsensitiveCompare(argv[iter], "-retain") || !caseInsensitiveCompare(argv[iter], "-retainPopped")) {
 			retainPopped = atoi(argv[++iter]);
+		} else if(!caseInsensitiveCompare(argv[iter], "-hugePages")) {
+			SlabPool::useHugePages = true;
+		} else if(!caseInsensitiveCompare(argv[iter], "-weightedDistances")) {
+			weightedDistances = true;
+		} else if(!caseInsensitiveCompare(argv[iter], "-anytime")) {
+			anytimeFileName = argv[++iter];
+		} else if(!caseInsensitiveCompare(argv[iter], "-timeLimit")) {
+			timeLimit = atof(argv[++iter]);
+		} else if(!caseInsensitiveCompare(argv[iter], "-nodeLimit")) {
+			nodeLimit = atol(argv[++iter]);
+		} else if(!caseInsensitiveCompare(argv[iter], "-ida")) {
+			idaTableSize = atol(argv[++iter]);
+			if(idaTableSize < 1) {
+				std::cerr << "FATAL ERROR: -ida needs a transposition table size of at least 1.\n";
+				exit(1);
+			}
+		} else if(!caseInsensitiveCompare(argv[iter], "-threads")) {
+			numThreads = atoi(argv[++iter]);
 		} else if(!caseInsensitiveCompare(argv[iter], "-qal")) {
 			++iter;
 			use_specified_init_mapping = 1;
-			int c = 0;
-			int i = 0;
-			while(argv[iter][c]) {
-				if(argv[iter][c] < '0' || argv[iter][c] > '9') {
-					if(argv[iter][c] != '-') {
-						c++;
-						continue;
-					}
-				}
-				init_qal[i++] = atoi(&(argv[iter][c]));
-			}
-			for(; i < MAX_QUBITS; i++) {
-				init_qal[i] = -1;
-			}
+			parseMapping(argv[iter], init_qal);
 		} else if(!caseInsensitiveCompare(argv[iter], "-laq")) {
 			++iter;
 			use_specified_init_mapping = 2;
-			int c = 0;
-			int i = 0;
-			while(argv[iter][c]) {
-				if(argv[iter][c] < '0' || argv[iter][c] > '9') {
-					if(argv[iter][c] != '-') {
-						c++;
-						continue;
-					}
-				}
-				init_laq[i++] = atoi(&(argv[iter][c]));
-			}
-			for(; i < MAX_QUBITS; i++) {
-				init_laq[i] = -1;
-			}
+			parseMapping(argv[iter], init_laq);
 		} else if(!caseInsensitiveCompare(argv[iter], "-default") || !caseInsensitiveCompare(argv[iter], "-defaults")) {
 			if(!ex) ex = std::get<0>(expanders[0]);
 			if(!cf) cf = std::get<0>(costFunctions[0]);
@@ -472,6 +607,11 @@ int main(int argc, char** argv) {
 		}
 	}
 	
+	if(numThreads > 1 && _verbose) {
+		std::cerr << "//Note: verbose mode isn't supported with multiple threads; ignoring -v.\n";
+		_verbose = false;
+	}
+	
 	bool userChoices = false;
 	
 	if(!ex) {
@@ -526,6 +666,21 @@ int main(int argc, char** argv) {
 		nodes->setArgs();
 	}
 	
+	if((timeLimit > 0 || nodeLimit > 0) && numThreads > 1) {
+		std::cerr << "FATAL ERROR: -timeLimit and -nodeLimit can't be used with -threads.\n";
+		exit(1);
+	}
+	
+	if(idaTableSize && (numThreads > 1 || anytimeFileName || timeLimit > 0 || nodeLimit > 0)) {
+		std::cerr << "FATAL ERROR: -ida can't be used with -threads, -anytime, -timeLimit, or -nodeLimit.\n";
+		exit(1);
+	}
+	
+	if(nodes->reexpandsNodes() && (retainPopped || numThreads > 1)) {
+		std::cerr << "FATAL ERROR: the selected queue re-expands nodes, so it can't be used with -retainPopped or -threads.\n";
+		exit(1);
+	}
+	
 	if(userChoices) {
 		int numselected;
 		
@@ -587,57 +742,47 @@ int main(int argc, char** argv) {
 	}
 	
 	env->latency = lat;
-	env->swapCost = lat->getLatency("swp", 2, -1, -1);
+	env->swapCost = lat->getLatency(GateType::SWP, 2, -1, -1);
 	env->cost = cf;
+	env->schedule = new ScheduleLog();
 	
 	set<GateNode*> firstGates;
 	int idealCycles = -1;
 	buildDependencyGraph(qasmFileName, lat, firstGates, env->numLogicalQubits, env, idealCycles);
 	
 	//Parse coupling map
-	buildCouplingMap(couplingMapFileName, env->couplings, env->numPhysicalQubits);
+	set<pair<int, int> > couplings;
+	buildCouplingMap(couplingMapFileName, couplings, env->numPhysicalQubits);
 	assert(env->numPhysicalQubits >= env->numLogicalQubits);
-	
-	//Calculate distances between physical qubits in coupling map (min 1, max numPhysicalQubits-1)
-	env->couplingDistances = new int[env->numPhysicalQubits*env->numPhysicalQubits];
-	for(int x = 0; x < env->numPhysicalQubits * env->numPhysicalQubits; x++) {
-		env->couplingDistances[x] = env->numPhysicalQubits - 1;
+	if(env->numPhysicalQubits > MAX_QUBITS) {
+		std::cerr << "FATAL ERROR: coupling map has " << env->numPhysicalQubits << " qubits; at most " << MAX_QUBITS << " are supported.\n";
+		exit(1);
 	}
-	for(auto iter = env->couplings.begin(); iter != env->couplings.end(); iter++) {
-		int x = (*iter).first;
-		int y = (*iter).second;
-		env->couplingDistances[x*env->numPhysicalQubits + y] = 1;
-		env->couplingDistances[y*env->numPhysicalQubits + x] = 1;
-	}
-	calcDistances(env->couplingDistances, env->numPhysicalQubits);
+	Node::setNumQubits(env->numPhysicalQubits);
+	lat->compile(env->numPhysicalQubits);
 	
-	if(initialSearchCycles < 0) {
-		int diameter = 0;
-		for(int x = 0; x < env->numPhysicalQubits - 1; x++) {
-			for(int y = x + 1; y < env->numPhysicalQubits; y++) {
-				if(env->couplingDistances[x*env->numPhysicalQubits + y] > diameter) {
-					diameter = env->couplingDistances[x*env->numPhysicalQubits + y];
-				}
+	//a user-specified mapping must fit the device; unspecified entries are unmapped
+	vector<int> & init_mapping = (use_specified_init_mapping == 1) ? init_qal : init_laq;
+	if(use_specified_init_mapping) {
+		if((int) init_mapping.size() > env->numPhysicalQubits) {
+			std::cerr << "FATAL ERROR: specified mapping has " << init_mapping.size() << " entries, but the coupling map only has " << env->numPhysicalQubits << " qubits.\n";
+			exit(1);
+		}
+		//qal entries name logical qubits, laq entries name physical qubits:
+		int limit = (use_specified_init_mapping == 1) ? env->numLogicalQubits : env->numPhysicalQubits;
+		for(unsigned int x = 0; x < init_mapping.size(); x++) {
+			if(init_mapping[x] >= limit) {
+				std::cerr << "FATAL ERROR: qubit index " << init_mapping[x] << " in specified mapping is out of range.\n";
+				exit(1);
 			}
 		}
-		initialSearchCycles = diameter;
+		init_mapping.resize(env->numPhysicalQubits, -1);
 	}
 	
-	//Prepare list of gates corresponding to possible swaps
-	//ToDo: make it so this won't cause redundancies when given directed coupling map
-		//might need to adjust parts of code that infer its size from coupling's size
-	env->possibleSwaps = new GateNode*[env->couplings.size()];
-	auto iter = env->couplings.begin();
-	int x = 0;
-	while(iter != env->couplings.end()) {
-		GateNode * g = new GateNode();
-		g->control = (*iter).first;
-		g->target = (*iter).second;
-		g->name = "swp";
-		g->optimisticLatency = lat->getLatency("swp", 2, g->target, g->control);
-		env->possibleSwaps[x] = g;
-		x++;
-		iter++;
+	//Calculate distances between physical qubits and prepare list of gates corresponding to possible swaps
+	env->device = new DeviceModel(env->numPhysicalQubits, couplings, lat, weightedDistances);
+	if(initialSearchCycles < 0) {
+		initialSearchCycles = env->device->diameter;
 	}
 	
 	//Set up root node (for cycle -1, before any gates are scheduled):
@@ -650,14 +795,14 @@ int main(int argc, char** argv) {
 		for(int x = 0; x < env->numPhysicalQubits; x++) {
 			root->qal[x] = init_qal[x];
 			if(init_qal[x] >= 0) {
-				root->laq[(int) init_qal[x]] = x;
+				root->laq[init_qal[x]] = x;
 			}
 		}
 	} else if(use_specified_init_mapping == 2) {
 		for(int x = 0; x < env->numPhysicalQubits; x++) {
 			root->laq[x] = init_laq[x];
 			if(init_laq[x] >= 0) {
-				root->qal[(int) init_laq[x]] = x;
+				root->qal[init_laq[x]] = x;
 			}
 		}
 	}
@@ -669,10 +814,16 @@ int main(int argc, char** argv) {
 		//std::cerr << "//Note: making attempt to find better initial mapping.\n";
 		root->cycle -= initialSearchCycles;
 	}
-	root->readyGates = firstGates;
-	root->scheduled = new LinkedStack<ScheduledGate*>;
+	for(GateNode * g : firstGates) {
+		root->readyGates.insert(g);
+	}
+	root->scheduled = 0;
+	root->numScheduled = 0;
+	root->rehash();
 	root->cost = cf->getCost(root);
-	nodes->push(root);
+	if(numThreads <= 1 && !idaTableSize) {
+		nodes->push(root);
+	}
 	
 	//Cleanup filters before I start messing things up:
 	for(int x = 0; x < NUMFILTERS; x++) {
@@ -689,14 +840,73 @@ int main(int argc, char** argv) {
 	}
 	env->resetFilters();
 	
-	//Pop nodes from the queue until we're done:
-	bool notDone = true;
+	//Unless a filter still compares against popped nodes, there's no reason to keep them around after expanding them:
+	if(!retainPopped && !nodes->reexpandsNodes()) {
+		bool needed = false;
+		for(unsigned int x = 0; x < env->filters.size(); x++) {
+			if(env->filters[x]->needsPoppedNodes()) {
+				needed = true;
+			}
+		}
+		if(!needed) {
+			retainPopped = 1;
+		}
+	}
+	
+	//In anytime mode (or with a limit), start off with a greedy schedule, and improve on it while the search runs:
+	GreedyCompleter * completer = NULL;
+	Node * incumbent = NULL;//best final node we found outside the search
+	int bestWrittenCost = INT_MAX;
+	const int anytimeInterval = 10000;//number of pops between attempts to finish a node greedily
+	if(anytimeFileName || timeLimit > 0 || nodeLimit > 0) {
+		//start with a greedy schedule, so we have something to fall back on whenever we stop
+		completer = new GreedyCompleter(ex);
+		incumbent = completer->complete(root);
+		if(anytimeFileName && incumbent) {
+			writeSchedule(anytimeFileName, incumbent);
+			bestWrittenCost = incumbent->cost;
+		} else if(anytimeFileName) {
+			std::cerr << "WARNING: couldn't complete a schedule greedily, so " << anytimeFileName << " stays unwritten until the search finds one.\n";
+		}
+	}
+	
+	//In parallel mode, the workers run the whole search (each with its own queue and filters):
+	HDAStar * parallelSearch = NULL;
+	if(numThreads > 1) {
+		parallelSearch = new HDAStar(env, nodes, ex, numThreads, retainPopped);
+		parallelSearch->run(root);
+	}
+	
+	//In IDA* mode, the queue goes unused; we search depth-first with ever larger cost thresholds instead:
+	IDAStar * iterativeSearch = NULL;
+	Node * iterativeResult = NULL;
+	if(idaTableSize) {
+		iterativeSearch = new IDAStar(env, ex, idaTableSize);
+		iterativeResult = iterativeSearch->run(root);
+		if(!iterativeResult) {
+			std::cerr << "FATAL ERROR: IDA* ran out of nodes without finding a complete schedule.\n";
+			exit(1);
+		}
+	}
+	
+	//Pop nodes from the queue until we're done (or we hit a limit):
+	bool notDone = !parallelSearch && !iterativeSearch;
+	auto startTime = std::chrono::steady_clock::now();
+	const char * limitHit = NULL;
+	int lowerBound = -1;
 	std::vector<Node*> tempNodes;
 	int numPopped = 0;
 	int counter = 0;
 	std::deque<Node*> oldNodes;
 	while(notDone) {
-		assert(nodes->size() > 0);
+		if(nodes->size() == 0) {
+			//only queues that drop nodes (like a beam) can run out before the expander says we're done
+			if(!nodes->getBestFinalNode() && !incumbent) {
+				std::cerr << "FATAL ERROR: the queue ran out of nodes without finding a complete schedule.\n";
+				exit(1);
+			}
+			break;
+		}
 		
 		while(retainPopped && oldNodes.size() > retainPopped) {
 			Node * pop = oldNodes.front();
@@ -713,6 +923,10 @@ int main(int argc, char** argv) {
 		n->expanded = true;
 		
 		if(n->dead) {
+			if(n->requeued) {
+				//the queue still holds on to this node from when we first expanded it
+				continue;
+			}
 			if(n == nodes->getBestFinalNode()) {
 				oldNodes.push_back(n);
 			} else {
@@ -722,12 +936,15 @@ int main(int argc, char** argv) {
 			continue;
 		}
 		
-		oldNodes.push_back(n);
+		//queues that may push this node again hold on to it themselves
+		if(!nodes->reexpandsNodes()) {
+			oldNodes.push_back(n);
+		}
 		
 		/*
 		if(n->parent && n->parent->dead) {
 			std::cerr << "skipping child of dead node:\n";
-			printNode(std::cerr, lastNode->scheduled);
+			printNode(std::cerr, lastNode);
 			n->dead = true;
 			continue;
 		}
@@ -735,6 +952,60 @@ int main(int argc, char** argv) {
 		
 		numPopped++;
 		
+		//the expander would stop here if our greedy schedule were in the queue
+		//(unless the queue pops nodes in some other order, e.g. a beam, and may still find something cheaper):
+		if(incumbent && nodes->popsCheapestFirst() && n->cost >= incumbent->cost) {
+			break;
+		}
+		
+		if(anytimeFileName) {
+			Node * best = nodes->getBestFinalNode();
+			if(best && best->cost < bestWrittenCost) {
+				writeSchedule(anytimeFileName, best);
+				bestWrittenCost = best->cost;
+			}
+			
+			//now and then, see whether finishing the current node greedily beats our best schedule so far:
+			if(numPopped % anytimeInterval == 0 && n->readyGates.size() && n->cost < bestWrittenCost) {
+				Node * candidate = completer->complete(n);
+				if(candidate && candidate->cost < bestWrittenCost) {
+					delete incumbent;
+					incumbent = candidate;
+					writeSchedule(anytimeFileName, incumbent);
+					bestWrittenCost = incumbent->cost;
+				} else {
+					delete candidate;
+				}
+			}
+		}
+		
+		//When we hit a limit, settle for finishing the most promising node greedily:
+		if(nodeLimit > 0 && numPopped >= nodeLimit) {
+			limitHit = "node";
+		} else if(timeLimit > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() >= timeLimit) {
+			limitHit = "time";
+		} else if(nodes->isOutOfMemory()) {
+			limitHit = "memory";
+		}
+		if(limitHit) {
+			if(nodes->popsCheapestFirst()) {
+				lowerBound = n->cost;
+			}
+			if(!completer) {
+				completer = new GreedyCompleter(ex);
+			}
+			if(n->readyGates.size()) {
+				Node * candidate = completer->complete(n);
+				if(candidate && (!incumbent || candidate->cost < incumbent->cost)) {
+					delete incumbent;
+					incumbent = candidate;
+				} else {
+					delete candidate;
+				}
+			}
+			break;
+		}
+		
 		//In verbose mode, we pause after popping some number of nodes:
 		if(_verbose && counter <= 0) {
 			cerr << "cycle " << n->cycle << "\n";
@@ -753,13 +1024,13 @@ int main(int argc, char** argv) {
 			std::cerr << "//" << (numPopped-1) << " nodes popped from queue so far.\n";
 			std::cerr << "//" << nodes->size() << " nodes remain in queue.\n";
 			env->printFilterStats(std::cerr);
-			//printNode(std::cerr, n->scheduled);
+			//printNode(std::cerr, n);
 			//cf->getCost(n);
 			for(GateNode * ready : n->readyGates) {
 				std::cerr << "ready: ";
 				int control = (ready->control >= 0) ? n->laq[ready->control] : -1;
 				int target = (ready->target >= 0) ? n->laq[ready->target] : -1;
-				std::cerr << ready->name << " ";
+				std::cerr << ready->name() << " ";
 				if(ready->control >= 0) {
 					std::cerr << "q[" << control << "],";
 				}
@@ -768,7 +1039,7 @@ int main(int argc, char** argv) {
 				
 				target = ready->target;
 				control = ready->control;
-				std::cerr << " //" << ready->name << " ";
+				std::cerr << " //" << ready->name() << " ";
 				if(control >= 0) {
 					std::cerr << "q[" << control << "],";
 				}
@@ -785,106 +1056,64 @@ int main(int argc, char** argv) {
 		counter--;
 	}
 	
-	Node * finalNode = nodes->getBestFinalNode();
-	
-	
-	//Figure out what the initial mapping must have been
-	LinkedStack<ScheduledGate*> * sg = finalNode->scheduled;
-	char inferredQal[env->numPhysicalQubits];
-	char inferredLaq[env->numPhysicalQubits];
-	for(int x = 0; x < env->numPhysicalQubits; x++) {
-		inferredQal[x] = finalNode->qal[x];
-		inferredLaq[x] = finalNode->laq[x];
+	Node * finalNode = parallelSearch ? parallelSearch->getBestFinalNode() : nodes->getBestFinalNode();
+	if(iterativeSearch) {
+		finalNode = iterativeResult;
 	}
-	/*
-	std::cerr << "//Note: qubit mapping at end (location of each logical qubit): ";
-	for(int x = 0; x < env->numLogicalQubits; x++) {
-		std::cerr << (int)inferredLaq[x] << ", ";
+	if(incumbent && (!finalNode || incumbent->cost < finalNode->cost)) {
+		finalNode = incumbent;
 	}
-	std::cerr << "\n";
-	std::cerr << "//Note: qubit mapping at end (logical qubit at each location): ";
-	for(int x = 0; x < env->numPhysicalQubits; x++) {
-		std::cerr << (int)inferredQal[x] << ", ";
+	if(!finalNode) {
+		std::cerr << "FATAL ERROR: couldn't find a complete schedule before the " << limitHit << " limit.\n";
+		exit(1);
 	}
-	std::cerr << "\n";
-	*/
-	while(sg->size > 0) {
-		if(sg->value->gate->control >= 0) {
-			if((!sg->value->gate->name.compare("swp")) || (!sg->value->gate->name.compare("SWP"))) {
-				
-				if(inferredQal[sg->value->physicalControl] >= 0 && inferredQal[sg->value->physicalTarget] >= 0) {
-					std::swap(inferredLaq[(int)inferredQal[sg->value->physicalControl]], inferredLaq[(int)inferredQal[sg->value->physicalTarget]]);
-				} else if(inferredQal[sg->value->physicalControl] >= 0) {
-					inferredLaq[(int)inferredQal[sg->value->physicalControl]] = sg->value->physicalTarget;
-				} else if(inferredQal[sg->value->physicalTarget] >= 0) {
-					inferredLaq[(int)inferredQal[sg->value->physicalTarget]] = sg->value->physicalControl;
-				}
-				
-				std::swap(inferredQal[sg->value->physicalTarget], inferredQal[sg->value->physicalControl]);
-			}
-		} else {
-			if(sg->value->physicalTarget < 0) {
-				sg->value->physicalTarget = inferredLaq[sg->value->gate->target];
-			}
-			
-			//in case this qubit's assignment is arbitrary:
-			if(sg->value->physicalTarget < 0) {
-				for(int x = 0; x < env->numPhysicalQubits; x++) {
-					if(inferredQal[x] < 0) {
-						inferredQal[x] = sg->value->gate->target;
-						inferredLaq[sg->value->gate->target] = x;
-						sg->value->physicalTarget = x;
-						break;
-					}
-				}
-			}
-		}
-		sg = sg->next;
+	if(anytimeFileName && finalNode->cost < bestWrittenCost) {
+		writeSchedule(anytimeFileName, finalNode);
 	}
 	
-	//Print out the initial mapping:
-	std::cout << "//Note: initial mapping (logical qubit at each location): ";
-	for(int x = 0; x < env->numPhysicalQubits; x++) {
-		std::cout << (int)inferredQal[x] << ", ";
-	}
-	std::cout << "\n";
-	std::cout << "//Note: initial mapping (location of each logical qubit): ";
-	for(int x = 0; x < env->numLogicalQubits; x++) {
-		std::cout << (int)inferredLaq[x] << ", ";
-	}
-	std::cout << "\n";
 	
-	//Print the OPENQASM output:
-	std::cout << "OPENQASM " << env->QASM_version << ";\n";
-	for(unsigned int x = 0; x < env->includes.size(); x++) {
-		std::cout << "include " << env->includes[x] << ";\n";
-	}
-	for(unsigned int x = 0; x < env->customGates.size(); x++) {
-		std::cout << "gate " << env->customGates[x] << "\n";
-	}
-	for(unsigned int x = 0; x < env->opaqueGates.size(); x++) {
-		std::cout << "opaque " << env->opaqueGates[x] << "\n";
-	}
-	std::cout << "qreg q[" << env->numPhysicalQubits << "];\n";
-	std::cout << "creg c[" << env->numPhysicalQubits << "];\n";
-	int numCycles = printNode(std::cout, finalNode->scheduled);
-	for(unsigned int x = 0; x < env->measures.size(); x++) {
-		std::cout << "measure q[" << (int) finalNode->laq[env->measures[x].first] << "] -> c[" << env->measures[x].second << "];\n";
-	}
+	int numCycles = printSchedule(std::cout, finalNode);
 	
 	//if(_verbose) {
 		//Print some metadata about the input & output:
 		std::cout << "//" << env->numGates << " original gates\n";
-		std::cout << "//" << finalNode->scheduled->size << " gates in generated circuit\n";
+		std::cout << "//" << finalNode->numScheduled << " gates in generated circuit\n";
 		std::cout << "//" << idealCycles << " ideal depth (cycles)\n";
 		std::cout << "//" << numCycles << " depth of generated circuit\n"; //" (and costFunc reports " << finalNode->cost << ")\n";
-		std::cout << "//" << (numPopped-1) << " nodes popped from queue for processing.\n";
-		std::cout << "//" << nodes->size() << " nodes remain in queue.\n";
-		env->printFilterStats(std::cout);
+		if(limitHit) {
+			std::cout << "//Note: search stopped at the " << limitHit << " limit, so this schedule may not be optimal.\n";
+			std::cout << "//" << finalNode->cost << " cost of generated circuit\n";
+			if(lowerBound >= 0) {
+				std::cout << "//" << lowerBound << " lower bound on cost (from the most promising open node)\n";
+			}
+		}
+		if(parallelSearch) {
+			std::cout << "//" << parallelSearch->getNumPopped() << " nodes popped from queue for processing.\n";
+			std::cout << "//" << parallelSearch->size() << " nodes remain in queue.\n";
+			parallelSearch->printFilterStats(std::cout);
+		} else if(iterativeSearch) {
+			std::cout << "//" << iterativeSearch->getNumExpanded() << " nodes expanded.\n";
+			iterativeSearch->printStatistics(std::cout);
+		} else {
+			std::cout << "//" << (numPopped-1) << " nodes popped from queue for processing.\n";
+			std::cout << "//" << nodes->size() << " nodes remain in queue.\n";
+			env->printFilterStats(std::cout);
+		}
+		std::cout << "//schedule log holds " << env->schedule->getNumLive() << " live entries, in " << env->schedule->getBytesReserved() << " bytes.\n";
 	//}
 	
 	//Cleanup
-	while(nodes->size()) {
+	if(parallelSearch) {
+		delete parallelSearch;
+	}
+	if(iterativeSearch) {
+		delete iterativeSearch;
+		delete iterativeResult;
+		delete root;
+	}
+	delete completer;
+	delete incumbent;
+	while(!nodes->reexpandsNodes() && nodes->size()) {
 		Node * n = nodes->pop();
 		delete n;
 	}
@@ -908,12 +1137,9 @@ int main(int argc, char** argv) {
 	for(int x = 0; x < NUMQUEUES; x++) {
 		delete std::get<0>(queues[x]);
 	}
-	for(unsigned int x = 0; x < env->couplings.size(); x++) {
-		delete env->possibleSwaps[x];
-	}
-	delete [] env->possibleSwaps;
+	delete env->device;
 	delete [] env->firstCXPerQubit;
-	delete [] env->couplingDistances;
+	delete env->schedule;
 	delete env;
 	
 	return 0;
@@ -0,0 +1,103 @@
+OPENQASM 2.0;
+include "qelib1.inc";
+qreg q[5];
+creg c[5];
+cx q[1],q[0];
+t q[0];
+t q[3];
+t q[3];
+h q[0];
+t q[0];
+t q[3];
+x q[0];
+x q[3];
+cx q[2],q[1];
+x q[0];
+t q[0];
+h q[0];
+x q[4];
+h q[3];
+x q[1];
+t q[0];
+x q[1];
+cx q[3],q[4];
+x q[1];
+t q[1];
+x q[1];
+t q[2];
+h q[3];
+x q[0];
+h q[2];
+h q[2];
+cx q[4],q[3];
+x q[1];
+t q[2];
+x q[3];
+x q[3];
+x q[0];
+t q[1];
+x q[3];
+t q[1];
+cx q[2],q[4];
+h q[3];
+x q[4];
+h q[1];
+x q[3];
+t q[3];
+x q[0];
+t q[0];
+t q[4];
+cx q[4],q[3];
+x q[1];
+h q[4];
+h q[0];
+h q[4];
+x q[1];
+t q[4];
+t q[4];
+t q[3];
+cx q[2],q[0];
+t q[4];
+h q[4];
+x q[1];
+t q[0];
+t q[2];
+x q[4];
+h q[4];
+t q[3];
+cx q[2],q[3];
+t q[0];
+x q[4];
+x q[4];
+t q[3];
+x q[0];
+h q[1];
+x q[4];
+h q[0];
+cx q[4],q[2];
+h q[0];
+h q[0];
+t q[0];
+t q[1];
+t q[0];
+x q[1];
+t q[2];
+h q[1];
+cx q[1],q[2];
+x q[1];
+x q[2];
+x q[2];
+t q[2];
+t q[3];
+h q[0];
+t q[3];
+t q[3];
+cx q[1],q[2];
+h q[2];
+x q[4];
+h q[4];
+t q[0];
+h q[0];
+t q[1];
+h q[1];
+t q[4];
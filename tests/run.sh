@@ -0,0 +1,183 @@
+#!/bin/sh
+# Maps small circuits and checks the depth of each generated circuit against the optimal one.
+# usage: tests/run.sh [mapper executable, ./mapper by default]
+
+dir=$(dirname "$0")
+mapper=${1:-./mapper}
+
+failures=0
+
+#check <expected depth> <circuit> <device> <mapper args...>
+check() {
+	expected=$1
+	circuit=$2
+	device=$3
+	shift 3
+	depth=$("$mapper" "$dir/$circuit" -defaults "$@" "$dir/$device" < /dev/null 2> /dev/null | sed -n 's|^//\([0-9]*\) depth of generated circuit$|\1|p')
+	if [ "$depth" = "$expected" ]; then
+		echo "ok: $circuit $device $*"
+	else
+		echo "FAILED: $circuit $device $* gave depth '$depth', expected $expected"
+		failures=$((failures + 1))
+	fi
+}
+
+#completes <circuit> <device> <mapper args...>: for searches that don't promise an optimal depth, only check that they finish
+completes() {
+	circuit=$1
+	device=$2
+	shift 2
+	depth=$("$mapper" "$dir/$circuit" -defaults "$@" "$dir/$device" < /dev/null 2> /dev/null | sed -n 's|^//\([0-9]*\) depth of generated circuit$|\1|p')
+	if [ -n "$depth" ]; then
+		echo "ok: $circuit $device $* (depth $depth)"
+	else
+		echo "FAILED: $circuit $device $* didn't generate a circuit"
+		failures=$((failures + 1))
+	fi
+}
+
+#bound <expected lower bound, or none> <circuit> <device> <mapper args...>: for searches that stop at a limit
+bound() {
+	expected=$1
+	circuit=$2
+	device=$3
+	shift 3
+	lower=$("$mapper" "$dir/$circuit" -defaults "$@" "$dir/$device" < /dev/null 2> /dev/null | sed -n 's|^//\([0-9]*\) lower bound on cost.*$|\1|p')
+	if [ "${lower:-none}" = "$expected" ]; then
+		echo "ok: $circuit $device $* (lower bound $expected)"
+	else
+		echo "FAILED: $circuit $device $* gave lower bound '${lower:-none}', expected $expected"
+		failures=$((failures + 1))
+	fi
+}
+
+#checkCircuit <circuit> <device> <generated circuit file>: prints what's wrong with the generated circuit, if anything:
+#it may only use coupled qubits, must apply each original gate to the qubits holding its logical qubits, and must have every original gate
+checkCircuit() {
+	awk '
+		FILENAME == ARGV[1] { if($0 ~ /q\[/ && $0 !~ /^(OPENQASM|include|qreg|creg)/) original++; next }
+		FILENAME == ARGV[2] { if(FNR > 2) { coupled[$1 "," $2] = 1; coupled[$2 "," $1] = 1 } next }
+		/^\/\/Note: initial mapping \(logical qubit at each location\)/ {
+			sub(/^.*\): /, ""); n = split($0, m, /, */)
+			for(i = 1; i <= n; i++) if(m[i] != "") qal[i - 1] = m[i]
+			next
+		}
+		/^\/\/[0-9]+ depth of generated circuit/ { done = 1 }
+		/^[a-z].*q\[[0-9]+\].*\/\/cycle/ && !/^(OPENQASM|include|qreg|creg)/ {
+			line = $0
+			match(line, /q\[[0-9]+\](,q\[[0-9]+\])?/); args = substr(line, RSTART, RLENGTH)
+			gsub(/[^0-9,]/, "", args); np = split(args, p, ",")
+			if(np == 2 && !coupled[p[1] "," p[2]]) { bad = "uncoupled " line; exit }
+			if(line ~ /^swp /) { t = qal[p[1]]; qal[p[1]] = qal[p[2]]; qal[p[2]] = t; next }
+			gates++
+			orig = line; sub(/^.*\/\/cycle: [0-9]+ *\/\//, "", orig)
+			match(orig, /q\[[0-9]+\](,q\[[0-9]+\])?/); args = substr(orig, RSTART, RLENGTH)
+			gsub(/[^0-9,]/, "", args); nl = split(args, l, ",")
+			for(i = 1; i <= nl; i++) if(qal[p[i]] != l[i]) { bad = "misplaced " line; exit }
+		}
+		END { if(bad) print bad; else if(!done) print "no circuit"; else if(gates != original) print gates " of " original " gates" }
+	' "$dir/$1" "$dir/$2" "$3"
+}
+
+tmp=${TMPDIR:-/tmp}/toqm_test.$$
+
+#valid <circuit> <device> <mapper args...>: checks the generated circuit with checkCircuit
+valid() {
+	circuit=$1
+	device=$2
+	shift 2
+	"$mapper" "$dir/$circuit" -defaults "$@" "$dir/$device" < /dev/null > "$tmp" 2> /dev/null
+	problem=$(checkCircuit "$circuit" "$device" "$tmp")
+	rm -f "$tmp"
+	if [ -z "$problem" ]; then
+		echo "ok: $circuit $device $* (valid)"
+	else
+		echo "FAILED: $circuit $device $* gave an invalid circuit: $problem"
+		failures=$((failures + 1))
+	fi
+}
+
+#anytime <circuit> <device> <mapper args...>: checks the schedule -anytime leaves in its file with checkCircuit
+anytime() {
+	circuit=$1
+	device=$2
+	shift 2
+	rm -f "$tmp.anytime"
+	"$mapper" "$dir/$circuit" -defaults -anytime "$tmp.anytime" "$@" "$dir/$device" < /dev/null > /dev/null 2> /dev/null
+	if [ -f "$tmp.anytime" ]; then
+		problem=$(checkCircuit "$circuit" "$device" "$tmp.anytime")
+	else
+		problem="no file"
+	fi
+	rm -f "$tmp.anytime"
+	if [ -z "$problem" ]; then
+		echo "ok: $circuit $device -anytime $* (valid)"
+	else
+		echo "FAILED: $circuit $device -anytime $* left an invalid schedule: $problem"
+		failures=$((failures + 1))
+	fi
+}
+
+#tighter <circuit> <device> <mapper args...>: checks that -weightedDistances keeps the depth and pops fewer nodes
+tighter() {
+	circuit=$1
+	device=$2
+	shift 2
+	plain=$("$mapper" "$dir/$circuit" -defaults "$@" "$dir/$device" < /dev/null 2> /dev/null)
+	weighted=$("$mapper" "$dir/$circuit" -defaults "$@" -weightedDistances "$dir/$device" < /dev/null 2> /dev/null)
+	plainDepth=$(echo "$plain" | sed -n 's|^//\([0-9]*\) depth of generated circuit$|\1|p')
+	weightedDepth=$(echo "$weighted" | sed -n 's|^//\([0-9]*\) depth of generated circuit$|\1|p')
+	plainPopped=$(echo "$plain" | sed -n 's|^//\([0-9]*\) nodes popped.*$|\1|p')
+	weightedPopped=$(echo "$weighted" | sed -n 's|^//\([0-9]*\) nodes popped.*$|\1|p')
+	if [ -n "$plainDepth" ] && [ "$plainDepth" = "$weightedDepth" ] && [ "${weightedPopped:-0}" -gt 0 ] && [ "$weightedPopped" -lt "${plainPopped:-0}" ]; then
+		echo "ok: $circuit $device $* (popped $plainPopped, weighted $weightedPopped)"
+	else
+		echo "FAILED: $circuit $device $* gave depth '$plainDepth' popping '$plainPopped', weighted depth '$weightedDepth' popping '$weightedPopped'"
+		failures=$((failures + 1))
+	fi
+}
+
+check 43 random5.qasm grid2x3.txt
+
+#swap latencies 5 and 3 (not a multiple of the cheapest swap) have to tighten weighted distances, not round down to hop counts:
+check 42 random5.qasm grid3x3.txt -costFunction CXFull -latency Table "$dir/grid3x3_swp.txt" -weightedDistances
+tighter random5.qasm grid3x3.txt -costFunction CXFull -latency Table "$dir/grid3x3_swp.txt"
+tighter random5.qasm grid3x3.txt -latency Table "$dir/grid3x3_swp.txt"
+#qubits 0 and 3 of a line with 3-cycle swaps meet after two swaps in parallel (cycle 3), then a 2-cycle cx;
+#counting the path in units of the 2-cycle swap on 3-4 used to split it 2:1 and overestimate:
+check 5 one_cx.qasm line5.txt -latency Table "$dir/line5_swp.txt" -qal 0,-1,-1,1,-1 -weightedDistances -ida 1000
+check 5 one_cx.qasm line5.txt -latency Table "$dir/line5_swp.txt" -qal 0,-1,-1,1,-1 -weightedDistances
+
+#a budget small enough to forget nodes whose children are still queued or whose own children were forgotten:
+check 43 random5.qasm grid2x3.txt -queue MemoryBoundedQueue 1000
+check 43 random5.qasm grid2x3.txt -queue MemoryBoundedQueue 800
+#budgets that used to regenerate the same nodes forever; the last one can't hold the nodes at the optimal cost, so it gives up:
+check 43 random5.qasm grid3x3.txt -queue MemoryBoundedQueue 500
+check 43 random5.qasm grid3x3.txt -queue MemoryBoundedQueue 200K
+completes random5.qasm grid2x3.txt -queue MemoryBoundedQueue 100
+
+#a narrow beam that levels nodes by gates has to swap for a few levels in a row before it can schedule anything:
+completes random5.qasm grid3x3.txt -queue BeamQueue 5 gates
+completes random5.qasm grid3x3.txt -queue BeamQueue 1 gates -filter SignatureFilter
+
+#at a tiny node limit the schedule comes from greedy completion, which used to idle when waiting cost the same as swapping:
+valid one_cx.qasm line5.txt -latency Table "$dir/line5_swp.txt" -qal 0,-1,-1,1,-1 -nodeLimit 1
+valid one_cx.qasm line5.txt -latency Table "$dir/line5_swp.txt" -qal 0,-1,-1,-1,1 -nodeLimit 3
+valid random5.qasm grid3x3.txt -latency Table "$dir/grid3x3_swp.txt" -nodeLimit 1
+valid random5.qasm grid2x3.txt -nodeLimit 5
+
+#-anytime writes its greedy schedule before the search starts, so cutting the search off at once still leaves a complete one:
+anytime one_cx.qasm line5.txt -latency Table "$dir/line5_swp.txt" -qal 0,-1,-1,1,-1 -nodeLimit 1
+anytime random5.qasm grid3x3.txt -latency Table "$dir/grid3x3_swp.txt" -nodeLimit 1
+anytime random5.qasm grid2x3.txt -nodeLimit 1
+
+#a beam doesn't pop the cheapest node first, so a limit it never hits mustn't change its result, and it has no lower bound to report:
+check 49 random5.qasm grid3x3.txt -queue BeamQueue 50 gates -filter SignatureFilter
+check 49 random5.qasm grid3x3.txt -queue BeamQueue 50 gates -filter SignatureFilter -nodeLimit 100000
+bound none random5.qasm grid3x3.txt -queue BeamQueue 50 gates -filter SignatureFilter -nodeLimit 30
+
+if [ $failures -gt 0 ]; then
+	echo "$failures test(s) failed"
+	exit 1
+fi
+echo "all tests passed"